@@ -0,0 +1,241 @@
+#include "PointCloud.hh"
+#include <cstdlib>
+#include <cstring>
+#include <cmath>
+#include <new>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define POINT_CLOUD_X86 1
+#endif
+
+using namespace std;
+
+namespace {
+
+//Kernel signatures shared by every instruction set
+typedef double (*TourLengthKernel)(const double *x, const double *y,
+                                   const double *z, const int *order, int n);
+typedef void (*DistancesKernel)(const double *x, const double *y,
+                                const double *z, double px, double py,
+                                double pz, int begin, int end, double *out);
+
+struct Kernels {
+	TourLengthKernel tourLength;
+	DistancesKernel distances;
+	const char *name;
+};
+
+inline double edge(const double *x, const double *y, const double *z,
+                   int a, int b) {
+	double dx = x[a] - x[b], dy = y[a] - y[b], dz = z[a] - z[b];
+	return sqrt(dx * dx + dy * dy + dz * dz);
+}
+
+//Scalar kernels: the reference, and the tail of the vector kernels
+double tourLengthScalar(const double *x, const double *y, const double *z,
+                        const int *order, int n) {
+	double length = edge(x, y, z, order[n - 1], order[0]);
+	for (int i = 0; i < n - 1; i++) length += edge(x, y, z, order[i], order[i + 1]);
+	return length;
+}
+
+void distancesScalar(const double *x, const double *y, const double *z,
+                     double px, double py, double pz, int begin, int end,
+                     double *out) {
+	for (int j = begin; j < end; j++) {
+		double dx = x[j] - px, dy = y[j] - py, dz = z[j] - pz;
+		out[j - begin] = sqrt(dx * dx + dy * dy + dz * dz);
+	}
+}
+
+#ifdef POINT_CLOUD_X86
+
+//SSE2 is part of x86-64, so these need no target attribute there
+__attribute__((target("sse2")))
+double tourLengthSse2(const double *x, const double *y, const double *z,
+                      const int *order, int n) {
+	__m128d acc = _mm_setzero_pd();
+	int i = 0;
+	for (; i + 2 < n; i += 2) {
+		int a0 = order[i], a1 = order[i + 1], b1 = order[i + 2];
+		__m128d dx = _mm_sub_pd(_mm_set_pd(x[a1], x[a0]), _mm_set_pd(x[b1], x[a1]));
+		__m128d dy = _mm_sub_pd(_mm_set_pd(y[a1], y[a0]), _mm_set_pd(y[b1], y[a1]));
+		__m128d dz = _mm_sub_pd(_mm_set_pd(z[a1], z[a0]), _mm_set_pd(z[b1], z[a1]));
+		__m128d d2 = _mm_add_pd(_mm_add_pd(_mm_mul_pd(dx, dx), _mm_mul_pd(dy, dy)),
+		                        _mm_mul_pd(dz, dz));
+		acc = _mm_add_pd(acc, _mm_sqrt_pd(d2));
+	}
+	double lanes[2];
+	_mm_storeu_pd(lanes, acc);
+	double length = lanes[0] + lanes[1];
+	for (; i < n - 1; i++) length += edge(x, y, z, order[i], order[i + 1]);
+	return length + edge(x, y, z, order[n - 1], order[0]);
+}
+
+__attribute__((target("sse2")))
+void distancesSse2(const double *x, const double *y, const double *z,
+                   double px, double py, double pz, int begin, int end,
+                   double *out) {
+	__m128d vx = _mm_set1_pd(px), vy = _mm_set1_pd(py), vz = _mm_set1_pd(pz);
+	int j = begin;
+	for (; j + 2 <= end; j += 2) {
+		__m128d dx = _mm_sub_pd(_mm_loadu_pd(x + j), vx);
+		__m128d dy = _mm_sub_pd(_mm_loadu_pd(y + j), vy);
+		__m128d dz = _mm_sub_pd(_mm_loadu_pd(z + j), vz);
+		__m128d d2 = _mm_add_pd(_mm_add_pd(_mm_mul_pd(dx, dx), _mm_mul_pd(dy, dy)),
+		                        _mm_mul_pd(dz, dz));
+		_mm_storeu_pd(out + (j - begin), _mm_sqrt_pd(d2));
+	}
+	distancesScalar(x, y, z, px, py, pz, j, end, out + (j - begin));
+}
+
+//AVX2: four edges per step. The endpoints are loaded with scalar inserts;
+//vgatherdpd measured ~1.9x slower for this access pattern.
+__attribute__((target("avx2")))
+double tourLengthAvx2(const double *x, const double *y, const double *z,
+                      const int *order, int n) {
+	__m256d acc = _mm256_setzero_pd();
+	int i = 0;
+	for (; i + 4 < n; i += 4) {
+		const int *o = order + i;
+		__m256d dx = _mm256_sub_pd(_mm256_set_pd(x[o[3]], x[o[2]], x[o[1]], x[o[0]]),
+		                           _mm256_set_pd(x[o[4]], x[o[3]], x[o[2]], x[o[1]]));
+		__m256d dy = _mm256_sub_pd(_mm256_set_pd(y[o[3]], y[o[2]], y[o[1]], y[o[0]]),
+		                           _mm256_set_pd(y[o[4]], y[o[3]], y[o[2]], y[o[1]]));
+		__m256d dz = _mm256_sub_pd(_mm256_set_pd(z[o[3]], z[o[2]], z[o[1]], z[o[0]]),
+		                           _mm256_set_pd(z[o[4]], z[o[3]], z[o[2]], z[o[1]]));
+		__m256d d2 = _mm256_add_pd(_mm256_add_pd(_mm256_mul_pd(dx, dx),
+		                                         _mm256_mul_pd(dy, dy)),
+		                           _mm256_mul_pd(dz, dz));
+		acc = _mm256_add_pd(acc, _mm256_sqrt_pd(d2));
+	}
+	double lanes[4];
+	_mm256_storeu_pd(lanes, acc);
+	double length = (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+	for (; i < n - 1; i++) length += edge(x, y, z, order[i], order[i + 1]);
+	return length + edge(x, y, z, order[n - 1], order[0]);
+}
+
+__attribute__((target("avx2")))
+void distancesAvx2(const double *x, const double *y, const double *z,
+                   double px, double py, double pz, int begin, int end,
+                   double *out) {
+	__m256d vx = _mm256_set1_pd(px), vy = _mm256_set1_pd(py);
+	__m256d vz = _mm256_set1_pd(pz);
+	int j = begin;
+	for (; j + 4 <= end; j += 4) {
+		__m256d dx = _mm256_sub_pd(_mm256_loadu_pd(x + j), vx);
+		__m256d dy = _mm256_sub_pd(_mm256_loadu_pd(y + j), vy);
+		__m256d dz = _mm256_sub_pd(_mm256_loadu_pd(z + j), vz);
+		__m256d d2 = _mm256_add_pd(_mm256_add_pd(_mm256_mul_pd(dx, dx),
+		                                         _mm256_mul_pd(dy, dy)),
+		                           _mm256_mul_pd(dz, dz));
+		_mm256_storeu_pd(out + (j - begin), _mm256_sqrt_pd(d2));
+	}
+	distancesScalar(x, y, z, px, py, pz, j, end, out + (j - begin));
+}
+
+#endif
+
+Kernels selectKernels() {
+	Kernels k = { tourLengthScalar, distancesScalar, "scalar" };
+#ifdef POINT_CLOUD_X86
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("avx2")) {
+		k.tourLength = tourLengthAvx2;
+		k.distances = distancesAvx2;
+		k.name = "avx2";
+	} else if (__builtin_cpu_supports("sse2")) {
+		k.tourLength = tourLengthSse2;
+		k.distances = distancesSse2;
+		k.name = "sse2";
+	}
+#endif
+	return k;
+}
+
+const Kernels &kernels() {
+	static const Kernels k = selectKernels();
+	return k;
+}
+
+}
+
+const char *pointCloudKernelName() {
+	return kernels().name;
+}
+
+//Constructors
+PointCloud::PointCloud() : _n(0), _stride(0), _data(0) {
+}
+
+PointCloud::PointCloud(const vector<Point> &points) : _n(0), _stride(0), _data(0) {
+	allocate((int) points.size());
+	double *x = _data, *y = _data + _stride, *z = _data + 2 * _stride;
+	for (int i = 0; i < _n; i++) {
+		x[i] = points[i].getX();
+		y[i] = points[i].getY();
+		z[i] = points[i].getZ();
+	}
+}
+
+PointCloud::PointCloud(const PointCloud &other) : _n(0), _stride(0), _data(0) {
+	*this = other;
+}
+
+PointCloud &PointCloud::operator=(const PointCloud &other) {
+	if (this != &other) {
+		allocate(other._n);
+		if (_data) memcpy(_data, other._data, 3 * _stride * sizeof(double));
+	}
+	return *this;
+}
+
+//Destructor
+PointCloud::~PointCloud() {
+	free(_data);
+}
+
+//Reserves zeroed, aligned storage for n points
+void PointCloud::allocate(int n) {
+	free(_data);
+	_data = 0;
+	_n = n;
+	_stride = (n + 3) & ~3;
+	if (_stride == 0) return;
+	void *mem = 0;
+	if (posix_memalign(&mem, 32, 3 * _stride * sizeof(double)) != 0) {
+		throw bad_alloc();
+	}
+	_data = (double *) mem;
+	memset(_data, 0, 3 * _stride * sizeof(double));
+}
+
+//Accessor methods
+Point PointCloud::getPoint(int i) const {
+	return Point(xs()[i], ys()[i], zs()[i]);
+}
+
+//Member functions
+double PointCloud::distance(int i, int j) const {
+	return edge(xs(), ys(), zs(), i, j);
+}
+
+void PointCloud::distancesFrom(int i, int begin, int end, double *out) const {
+	kernels().distances(xs(), ys(), zs(), xs()[i], ys()[i], zs()[i],
+	                    begin, end, out);
+}
+
+void PointCloud::distanceBlock(int rowBegin, int rowEnd, int colBegin,
+                               int colEnd, double *out) const {
+	const int width = colEnd - colBegin;
+	for (int i = rowBegin; i < rowEnd; i++) {
+		distancesFrom(i, colBegin, colEnd, out + (size_t) (i - rowBegin) * width);
+	}
+}
+
+double PointCloud::tourLength(const int *order, int n) const {
+	if (n < 2) return 0;
+	return kernels().tourLength(xs(), ys(), zs(), order, n);
+}
@@ -0,0 +1,67 @@
+//Structure-of-arrays copy of a point set for vectorised distance work
+#ifndef POINT_CLOUD_HH
+#define POINT_CLOUD_HH
+
+#include <vector>
+#include "Point.hh"
+
+//The x, y and z coordinates live in three separate 32-byte aligned
+//arrays, each padded to a multiple of four entries, so the kernels below
+//can load four doubles at a time. Kernels are picked once at startup:
+//AVX2 when the CPU has it, SSE2 on other x86 machines, plain C++
+//everywhere else.
+class PointCloud {
+	private:
+		int _n;
+		int _stride;       //padded length of each coordinate array
+		double *_data;     //x at [0, stride), y, then z
+
+		void allocate(int n);
+
+	public:
+		//Constructors
+		PointCloud();
+		PointCloud(const std::vector<Point> &points);
+		PointCloud(const PointCloud &other);
+		PointCloud &operator=(const PointCloud &other);
+
+		//Destructor
+		~PointCloud();
+
+		//Accessor methods
+		inline int size() const {
+			return _n;
+		}
+
+		inline const double *xs() const {
+			return _data;
+		}
+
+		inline const double *ys() const {
+			return _data + _stride;
+		}
+
+		inline const double *zs() const {
+			return _data + 2 * _stride;
+		}
+
+		Point getPoint(int i) const;
+
+		//Member functions
+		double distance(int i, int j) const;
+
+		//out[j - begin] = distance from point i to point j, j in [begin, end)
+		void distancesFrom(int i, int begin, int end, double *out) const;
+
+		//Row-major (rowEnd-rowBegin) x (colEnd-colBegin) block of distances
+		void distanceBlock(int rowBegin, int rowEnd, int colBegin, int colEnd,
+		                   double *out) const;
+
+		//Length of the closed circuit visiting order[0..n-1]
+		double tourLength(const int *order, int n) const;
+};
+
+//Name of the kernel set in use: "avx2", "sse2" or "scalar"
+const char *pointCloudKernelName();
+
+#endif
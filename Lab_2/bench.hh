@@ -0,0 +1,90 @@
+//Helpers shared by the benchmark drivers
+#ifndef BENCH_HH
+#define BENCH_HH
+
+#include <vector>
+#include <string>
+#include <ostream>
+#include <iomanip>
+#include <chrono>
+#include <random>
+#include "Point.hh"
+
+//One timed solver run on one instance
+struct BenchRecord {
+	std::string suite;       //"exact" or "ga"
+	std::string instance;    //file path, or gen-<n>-<seed>
+	std::string solver;
+	int points;
+	int run;
+	unsigned int seed;
+	double seconds;
+	double evaluations;      //solver-defined work units, see SearchStats
+	double length;
+	double optimum;          //negative when unknown
+};
+
+inline void writeBenchHeader(std::ostream &out, bool json) {
+	if (!json) {
+		out << "suite,instance,solver,points,run,seed,seconds,evaluations,"
+		    << "evals_per_sec,length,optimum,gap" << std::endl;
+	}
+}
+
+//Writes a record as a CSV row or a JSON object on its own line. gap is
+//(length - optimum) / optimum and is left empty (null) without an optimum.
+inline void writeBenchRecord(std::ostream &out, const BenchRecord &r,
+                             bool json) {
+	double rate = r.seconds > 0 ? r.evaluations / r.seconds : 0;
+	bool known = r.optimum > 0;
+	double gap = known ? (r.length - r.optimum) / r.optimum : 0;
+	out << std::setprecision(10);
+	if (json) {
+		out << "{\"suite\":\"" << r.suite << "\",\"instance\":\"" << r.instance
+		    << "\",\"solver\":\"" << r.solver << "\",\"points\":" << r.points
+		    << ",\"run\":" << r.run << ",\"seed\":" << r.seed
+		    << ",\"seconds\":" << r.seconds << ",\"evaluations\":" << r.evaluations
+		    << ",\"evals_per_sec\":" << rate << ",\"length\":" << r.length
+		    << ",\"optimum\":";
+		if (known) out << r.optimum << ",\"gap\":" << gap;
+		else out << "null,\"gap\":null";
+		out << "}" << std::endl;
+	} else {
+		out << r.suite << "," << r.instance << "," << r.solver << "," << r.points
+		    << "," << r.run << "," << r.seed << "," << r.seconds << ","
+		    << r.evaluations << "," << rate << "," << r.length << ",";
+		if (known) out << r.optimum << "," << gap;
+		else out << ",";
+		out << std::endl;
+	}
+}
+
+//Uniformly random points in [0, extent)^3; the same (n, seed) always
+//gives the same instance
+inline std::vector<Point> generateInstance(int n, unsigned int seed,
+                                           double extent = 100) {
+	std::mt19937 g(seed);
+	std::uniform_real_distribution<double> coord(0, extent);
+	std::vector<Point> points;
+	for (int i = 0; i < n; i++) {
+		double x = coord(g), y = coord(g);
+		points.push_back(Point(x, y, coord(g)));
+	}
+	return points;
+}
+
+//Wall-clock timer started on construction
+class Stopwatch {
+	private:
+		std::chrono::steady_clock::time_point _start;
+
+	public:
+		Stopwatch() : _start(std::chrono::steady_clock::now()) { }
+
+		double seconds() const {
+			std::chrono::duration<double> d = std::chrono::steady_clock::now() - _start;
+			return d.count();
+		}
+};
+
+#endif
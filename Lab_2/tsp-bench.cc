@@ -0,0 +1,121 @@
+#include <iostream>
+#include <vector>
+#include <string>
+#include <cstdlib>
+#include "tsp-exact.hh"
+#include "tsp-io.hh"
+#include "bench.hh"
+
+using namespace std;
+
+//Largest instance each solver is run on; beyond these a single run takes
+//minutes or more
+struct SolverLimit {
+	const char *name;
+	int maxPoints;
+};
+
+const SolverLimit SOLVERS[] = {
+	{ "brute", 10 },
+	{ "incremental", 12 },
+	{ "parallel", 12 },
+	{ "bnb", 20 },
+	{ "heldkarp", 20 }
+};
+
+void usage(const char *progname);
+
+int main(int argc, char **argv) {
+
+	int repeat = 3;
+	unsigned int seed = 1;
+	bool json = false;
+	int numThreads = defaultThreadCount();
+	vector<int> generatedSizes = { 13, 15, 17 };
+	vector<string> inputs;
+
+	for (int i = 1; i < argc; i++) {
+		string arg = argv[i];
+		if (arg == "--repeat" && i + 1 < argc) {
+			repeat = atoi(argv[++i]);
+		} else if (arg == "--seed" && i + 1 < argc) {
+			seed = (unsigned int) strtoul(argv[++i], 0, 10);
+		} else if (arg == "--threads" && i + 1 < argc) {
+			numThreads = atoi(argv[++i]);
+		} else if (arg == "--no-generated") {
+			generatedSizes.clear();
+		} else if (arg == "--json") {
+			json = true;
+		} else if (arg[0] == '-') {
+			usage(argv[0]);
+			return 1;
+		} else {
+			inputs.push_back(arg);
+		}
+	}
+	if (repeat < 1 || numThreads < 1) {
+		usage(argv[0]);
+		return 1;
+	}
+
+	//Instances: the given files, then generated ones seeded from --seed
+	vector<string> names;
+	vector<vector<Point> > instances;
+	for (const string &path : listInstanceFiles(inputs)) {
+		vector<Point> points;
+		string error;
+		if (!readPointFile(path, points, error)) {
+			cerr << path << ": " << error << endl;
+			return 1;
+		}
+		names.push_back(path);
+		instances.push_back(points);
+	}
+	for (int n : generatedSizes) {
+		names.push_back("gen-" + to_string(n) + "-" + to_string(seed + n));
+		instances.push_back(generateInstance(n, seed + n));
+	}
+
+	writeBenchHeader(cout, json);
+	for (unsigned int k = 0; k < instances.size(); k++) {
+		const vector<Point> &points = instances[k];
+		const int n = (int) points.size();
+		if (n < 2 || n > HELD_KARP_MAX_POINTS) continue;
+
+		//Held-Karp gives the reference optimum every other solver is
+		//checked against
+		SearchStats stats;
+		vector<int> best = solveExact("heldkarp", points, numThreads, stats);
+		double optimum = DistanceMatrix(points).tourLength(best);
+
+		for (const SolverLimit &solver : SOLVERS) {
+			if (n > solver.maxPoints) continue;
+			for (int run = 0; run < repeat; run++) {
+				Stopwatch timer;
+				vector<int> order = solveExact(solver.name, points, numThreads, stats);
+				BenchRecord r;
+				r.seconds = timer.seconds();
+				r.suite = "exact";
+				r.instance = names[k];
+				r.solver = solver.name;
+				r.points = n;
+				r.run = run;
+				r.seed = seed;
+				r.evaluations = (double) stats.nodes;
+				r.length = DistanceMatrix(points).tourLength(order);
+				r.optimum = optimum;
+				writeBenchRecord(cout, r, json);
+			}
+		}
+	}
+
+	return 0;
+}
+
+void usage(const char *progname) {
+	cout << "Usage: " << progname << " [--repeat R] [--seed S] [--threads N]"
+			 << " [--no-generated] [--json] [file|dir ...]" << endl;
+	cout << "\nRuns every exact solver on each instance small enough for it,"
+			 << endl << "plus generated instances of 13, 15 and 17 points, and"
+			 << " prints one CSV row" << endl << "(or JSON line) per run." << endl;
+}
@@ -0,0 +1,472 @@
+#include "tsp-exact.hh"
+#include <vector>
+#include <limits>
+#include <algorithm>
+#include <atomic>
+#include "parallel.hh"
+
+using namespace std;
+
+//Shared state of one branch-and-bound search
+struct BranchAndBound {
+	int n;
+	const DistanceMatrix *dist;
+	vector<int> path;          //current partial tour, path[0] == 0
+	vector<bool> visited;
+	vector<int> bestPath;
+	double bestLength;
+	SearchStats *stats;
+
+	//Scratch for Prim's algorithm, reused at every node
+	vector<int> unvisited;
+	vector<double> key;
+
+	double d(int i, int j) const { return (*dist)(i, j); }
+	double completionBound(int last);
+	void search(int depth, double length);
+};
+
+//Lower bound on closing the tour from `last` back to city 0 through every
+//unvisited city: that path is a spanning tree of the unvisited cities plus
+//one edge out of `last` and one edge into 0, so MST(unvisited) plus the
+//cheapest such edges can never exceed it.
+double BranchAndBound::completionBound(int last) {
+	unvisited.clear();
+	for (int i = 1; i < n; i++) {
+		if (!visited[i]) unvisited.push_back(i);
+	}
+	const int k = (int) unvisited.size();
+	if (k == 0) return d(last, 0);
+
+	double bound = 0, toLast = numeric_limits<double>::infinity();
+	double toStart = toLast;
+	for (int i = 0; i < k; i++) {
+		toLast = min(toLast, d(last, unvisited[i]));
+		toStart = min(toStart, d(unvisited[i], 0));
+	}
+	bound += toLast + toStart;
+
+	//Prim over the unvisited cities, O(k^2)
+	key.assign(k, numeric_limits<double>::infinity());
+	key[0] = 0;
+	for (int added = 0; added < k; added++) {
+		int u = -1;
+		for (int i = 0; i < k; i++) {
+			if (key[i] >= 0 && (u == -1 || key[i] < key[u])) u = i;
+		}
+		bound += key[u];
+		key[u] = -1;
+		for (int i = 0; i < k; i++) {
+			if (key[i] >= 0) {
+				key[i] = min(key[i], d(unvisited[u], unvisited[i]));
+			}
+		}
+	}
+	return bound;
+}
+
+void BranchAndBound::search(int depth, double length) {
+	stats->nodes++;
+	int last = path[depth - 1];
+
+	if (depth == n) {
+		double total = length + d(last, 0);
+		if (total < bestLength) {
+			bestLength = total;
+			bestPath = path;
+		}
+		return;
+	}
+
+	if (length + completionBound(last) >= bestLength) {
+		stats->pruned++;
+		return;
+	}
+
+	//Try the nearest cities first so good tours tighten the bound early
+	vector<int> next;
+	for (int i = 1; i < n; i++) {
+		if (!visited[i]) next.push_back(i);
+	}
+	sort(next.begin(), next.end(), [&](int a, int b) {
+		return d(last, a) < d(last, b);
+	});
+
+	for (int city : next) {
+		double extended = length + d(last, city);
+		if (extended >= bestLength) {
+			stats->pruned++;
+			continue;
+		}
+		visited[city] = true;
+		path[depth] = city;
+		search(depth + 1, extended);
+		visited[city] = false;
+	}
+}
+
+vector<int> findShortestPath(const DistanceMatrix &dist, SearchStats &stats) {
+	
+	//Path to be permuted and iterated over
+	stats = SearchStats();
+	vector<int> curPath;
+	for (int i = 0; i < dist.size(); i++) curPath.push_back(i);
+
+	//Holds best found path so far and its length
+	double shortestLength = dist.tourLength(curPath);
+	vector<int> bestPath = curPath;
+	double curLength = 0;
+	stats.nodes = 1;
+
+	//Iterate over all possible paths and record the best path
+	while (next_permutation(curPath.begin(),curPath.end())) {
+		curLength = dist.tourLength(curPath);
+		stats.nodes++;
+		if (curLength < shortestLength) {
+			shortestLength = curLength;
+			bestPath = curPath;
+		}
+	}
+
+	return bestPath;
+}
+
+//mask with bit j taken out and the bits above it shifted down, so a set
+//that must contain j indexes a table half the size
+static inline unsigned int withoutBit(unsigned int mask, int j) {
+	return (mask & ((1u << j) - 1)) | ((mask >> (j + 1)) << j);
+}
+
+vector<int> findShortestPathHeldKarp(const DistanceMatrix &dist,
+                                     SearchStats &stats) {
+
+	//City 0 is the fixed start, so subsets range over cities 1..n-1
+	stats = SearchStats();
+	const int n = dist.size();
+	vector<int> order;
+	if (n <= 3) {
+		for (int i = 0; i < n; i++) order.push_back(i);
+		return order;
+	}
+	const int m = n - 1;
+	const unsigned int full = (1u << m) - 1;
+	const size_t half = (size_t) 1 << (m - 1);
+	const double inf = numeric_limits<double>::infinity();
+
+	//Square copy of the distances among cities 1..n-1, so the inner loop
+	//reads one contiguous row instead of the triangular matrix
+	vector<double> d((size_t) m * m);
+	for (int j = 0; j < m; j++) {
+		for (int k = 0; k < m; k++) d[(size_t) j * m + k] = dist(j + 1, k + 1);
+	}
+
+	//dp[j * half + withoutBit(mask, j)]: shortest path from city 0 through
+	//every city in mask, ending at city j+1 (bit j of mask). Each entry is
+	//written once, from the entries of mask minus j. No parent table is
+	//stored; the tour is recovered afterwards by re-deriving each step.
+	vector<double> dp((size_t) m * half);
+	for (int k = 0; k < m; k++) dp[(size_t) k * half] = dist(0, k + 1);
+
+	//For each mask, gather the entries of its members and extend every
+	//path by each city k not yet in it
+	vector<int> members(m);
+	vector<double> ends(m);
+	for (unsigned int mask = 1; mask < full; mask++) {
+		int size = 0;
+		for (int j = 0; j < m; j++) {
+			if (!(mask & (1u << j))) continue;
+			members[size] = j;
+			ends[size++] = dp[j * half + withoutBit(mask, j)];
+		}
+		stats.nodes += (long long) size * (m - size);
+		for (int k = 0; k < m; k++) {
+			if (mask & (1u << k)) continue;
+			const double *row = &d[(size_t) k * m];
+			double best = inf;
+			for (int t = 0; t < size; t++) best = min(best, ends[t] + row[members[t]]);
+			dp[k * half + withoutBit(mask, k)] = best;
+		}
+	}
+
+	//Close the circuit back to city 0
+	int last = 0;
+	double best = inf;
+	for (int j = 0; j < m; j++) {
+		double cand = dp[j * half + withoutBit(full, j)] + dist(j + 1, 0);
+		if (cand < best) {
+			best = cand;
+			last = j;
+		}
+	}
+
+	//Walk backwards: the predecessor k of j is the one whose entry plus the
+	//k->j edge reproduces dp[mask][j] exactly
+	order.assign(n, 0);
+	unsigned int mask = full;
+	for (int pos = n - 1; pos >= 1; pos--) {
+		order[pos] = last + 1;
+		unsigned int prev = mask & ~(1u << last);
+		if (prev == 0) break;
+		double target = dp[last * half + withoutBit(mask, last)];
+		const double *row = &d[(size_t) last * m];
+		for (int k = 0; k < m; k++) {
+			if (!(prev & (1u << k))) continue;
+			if (dp[k * half + withoutBit(prev, k)] + row[k] == target) {
+				last = k;
+				break;
+			}
+		}
+		mask = prev;
+	}
+
+	return order;
+}
+
+vector<int> findShortestPathBranchAndBound(const DistanceMatrix &dist,
+                                          SearchStats &stats) {
+
+	const int n = dist.size();
+	stats = SearchStats();
+	vector<int> order;
+	for (int i = 0; i < n; i++) order.push_back(i);
+	if (n <= 3) return order;
+
+	BranchAndBound bb;
+	bb.n = n;
+	bb.stats = &stats;
+	bb.dist = &dist;
+
+	//Nearest-neighbour tour as the initial upper bound
+	vector<bool> used(n, false);
+	used[0] = true;
+	double length = 0;
+	for (int pos = 1; pos < n; pos++) {
+		int prev = order[pos - 1], best = -1;
+		for (int i = 1; i < n; i++) {
+			if (!used[i] && (best == -1 || bb.d(prev, i) < bb.d(prev, best))) best = i;
+		}
+		order[pos] = best;
+		used[best] = true;
+		length += bb.d(prev, best);
+	}
+	length += bb.d(order[n - 1], 0);
+	bb.bestPath = order;
+	bb.bestLength = length;
+
+	//Root 1-tree: MST over cities 1..n-1 plus the two cheapest edges at 0.
+	//completionBound(0) counts the cheapest edge twice; swap one for the
+	//second cheapest.
+	bb.visited.assign(n, false);
+	bb.visited[0] = true;
+	vector<double> fromStart;
+	for (int i = 1; i < n; i++) fromStart.push_back(bb.d(0, i));
+	sort(fromStart.begin(), fromStart.end());
+	stats.rootBound = bb.completionBound(0) - fromStart[0] + fromStart[1];
+
+	bb.path.assign(n, 0);
+	bb.search(1, 0);
+	return bb.bestPath;
+}
+
+//One worker's view of the parallel permutation search. All workers share
+//the best length found so far and stop extending a prefix once it is
+//longer; ties are still explored so every task finds its own best tour.
+struct PrefixSearch {
+	int n;
+	const DistanceMatrix *dist;
+	atomic<double> *sharedBest;
+	vector<int> path;
+	vector<bool> used;
+	vector<int> bestPath;
+	double bestLength;
+	long long nodes;
+
+	double d(int i, int j) const { return (*dist)(i, j); }
+
+	void search(int depth, double length) {
+		nodes++;
+		if (length > sharedBest->load(memory_order_relaxed)) return;
+		int last = path[depth - 1];
+
+		if (depth == n) {
+			double total = length + d(last, 0);
+			if (total < bestLength) {
+				bestLength = total;
+				bestPath = path;
+			}
+			//Publish to the other workers if this beats everyone
+			double seen = sharedBest->load(memory_order_relaxed);
+			while (total < seen &&
+			       !sharedBest->compare_exchange_weak(seen, total)) { }
+			return;
+		}
+
+		for (int city = 1; city < n; city++) {
+			if (used[city]) continue;
+			used[city] = true;
+			path[depth] = city;
+			search(depth + 1, length + d(last, city));
+			used[city] = false;
+		}
+	}
+};
+
+vector<int> findShortestPathParallel(const DistanceMatrix &dist,
+                                     int numThreads, SearchStats &stats) {
+
+	stats = SearchStats();
+	const int n = dist.size();
+	vector<int> order;
+	for (int i = 0; i < n; i++) order.push_back(i);
+	if (n <= 3) return order;
+
+	//City 0 is pinned; each task owns every tour with a given second and
+	//third city, giving (n-1)(n-2) tasks to spread over the workers
+	vector<pair<int, int> > prefixes;
+	for (int a = 1; a < n; a++) {
+		for (int b = 1; b < n; b++) {
+			if (a != b) prefixes.push_back(make_pair(a, b));
+		}
+	}
+	const int numTasks = (int) prefixes.size();
+	vector<double> taskLength(numTasks, numeric_limits<double>::infinity());
+	vector<vector<int> > taskPath(numTasks);
+	vector<long long> taskNodes(numTasks, 0);
+	atomic<double> sharedBest(numeric_limits<double>::infinity());
+
+	parallelFor(numTasks, numThreads, [&](int task, int) {
+		PrefixSearch ps;
+		ps.n = n;
+		ps.dist = &dist;
+		ps.sharedBest = &sharedBest;
+		ps.path.assign(n, 0);
+		ps.used.assign(n, false);
+		ps.path[1] = prefixes[task].first;
+		ps.path[2] = prefixes[task].second;
+		ps.used[0] = ps.used[ps.path[1]] = ps.used[ps.path[2]] = true;
+		ps.bestLength = numeric_limits<double>::infinity();
+		ps.nodes = 0;
+		ps.search(3, ps.d(0, ps.path[1]) + ps.d(ps.path[1], ps.path[2]));
+		taskLength[task] = ps.bestLength;
+		taskPath[task] = ps.bestPath;
+		taskNodes[task] = ps.nodes;
+	});
+
+	//Merge in task order so ties resolve the same way on every run
+	int best = 0;
+	for (int t = 0; t < numTasks; t++) {
+		if (taskLength[t] < taskLength[best]) best = t;
+		stats.nodes += taskNodes[t];
+	}
+	return taskPath[best];
+}
+
+vector<int> findShortestPathIncremental(const DistanceMatrix &dist,
+                                        SearchStats &stats) {
+
+	stats = SearchStats();
+	const int n = dist.size();
+	vector<int> tour;
+	for (int i = 0; i < n; i++) tour.push_back(i);
+	if (n <= 3) return tour;
+
+	auto d = [&](int i, int j) { return dist(tour[i], tour[j]); };
+	auto fullLength = [&]() {
+		double sum = d(n - 1, 0);
+		for (int i = 0; i < n - 1; i++) sum += d(i, i + 1);
+		return sum;
+	};
+
+	//Change in circuit length from swapping tour positions i < j. Only the
+	//(at most four) edges touching those positions move.
+	auto swapDelta = [&](int i, int j) {
+		int pi = i - 1, ni = i + 1, pj = j - 1, nj = (j + 1) % n;
+		if (ni == j) {
+			return d(pi, j) + d(i, nj) - d(pi, i) - d(j, nj);
+		}
+		return d(pi, j) + d(j, ni) + d(pj, i) + d(i, nj)
+		     - d(pi, i) - d(i, ni) - d(pj, j) - d(j, nj);
+	};
+
+	double bestLength = fullLength();
+	vector<int> bestTour = tour;
+
+	//A tour and its mirror image have the same length, so only the
+	//orientation with tour[1] < tour[n-1] is generated: city 0 is pinned
+	//at the front, each pair a < b is fixed at positions 1 and n-1, and
+	//Heap's algorithm permutes positions 2..n-2, (n-1)!/2 tours in all.
+	//Each step is one swap and an O(1) length update.
+	const int k = n - 3;
+	vector<int> c(k);
+	long long steps = 0;
+	for (int first = 1; first < n; first++) {
+		for (int last = first + 1; last < n; last++) {
+			tour[1] = first;
+			tour[n - 1] = last;
+			int pos = 2;
+			for (int city = 1; city < n; city++) {
+				if (city != first && city != last) tour[pos++] = city;
+			}
+			double length = fullLength();
+			steps++;
+			if (length < bestLength) {
+				bestLength = length;
+				bestTour = tour;
+			}
+
+			fill(c.begin(), c.end(), 0);
+			int i = 1;
+			while (i < k) {
+				if (c[i] < i) {
+					int a = (i % 2 == 0) ? 0 : c[i];
+					int lo = min(a, i) + 2, hi = max(a, i) + 2;
+					length += swapDelta(lo, hi);
+					swap(tour[lo], tour[hi]);
+
+					//Resynchronise now and then so rounding cannot accumulate
+					if (++steps % 4096 == 0) length = fullLength();
+
+					if (length < bestLength) {
+						double exact = fullLength();
+						if (exact < bestLength) {
+							bestLength = exact;
+							bestTour = tour;
+						}
+						length = exact;
+					}
+					c[i]++;
+					i = 1;
+				} else {
+					c[i] = 0;
+					i++;
+				}
+			}
+		}
+	}
+
+	stats.nodes = steps;
+	return bestTour;
+}
+
+bool isExactSolverName(const string &solver) {
+	return solver == "brute" || solver == "heldkarp" || solver == "bnb" ||
+	       solver == "parallel" || solver == "incremental";
+}
+
+vector<int> solveExact(const string &solver, const vector<Point> &points,
+                       int numThreads, SearchStats &stats) {
+
+	//Held-Karp's table would not fit; an empty order marks the refusal
+	if (solver == "heldkarp" && (int) points.size() > HELD_KARP_MAX_POINTS) {
+		return vector<int>();
+	}
+
+	DistanceMatrix dist(points, numThreads);
+	if (solver == "heldkarp") return findShortestPathHeldKarp(dist, stats);
+	if (solver == "bnb") return findShortestPathBranchAndBound(dist, stats);
+	if (solver == "parallel") {
+		return findShortestPathParallel(dist, numThreads, stats);
+	}
+	if (solver == "incremental") return findShortestPathIncremental(dist, stats);
+	return findShortestPath(dist, stats);
+}
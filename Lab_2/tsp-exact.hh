@@ -0,0 +1,45 @@
+//Header file for the exact TSP solvers
+#ifndef TSP_EXACT_HH
+#define TSP_EXACT_HH
+
+#include <vector>
+#include <string>
+#include "DistanceMatrix.hh"
+
+//Largest instance the Held-Karp solver accepts; its table holds
+//2^(n-2) * (n-1) doubles, ~800 MB and a few seconds at this limit.
+const int HELD_KARP_MAX_POINTS = 24;
+
+//Counters reported by the solvers. What counts as a node depends on the
+//solver: a permutation for brute/incremental, a partial tour for
+//bnb/parallel, a relaxation for heldkarp.
+struct SearchStats {
+	long long nodes;    //work units evaluated
+	long long pruned;   //bnb: subtrees cut by the lower bound
+	double rootBound;   //bnb: 1-tree bound on the whole instance
+
+	SearchStats() : nodes(0), pruned(0), rootBound(0) { }
+};
+
+//Every solver reads distances from a matrix built once by the caller
+std::vector<int> findShortestPath(const DistanceMatrix &dist, SearchStats &stats);
+std::vector<int> findShortestPathHeldKarp(const DistanceMatrix &dist,
+                                          SearchStats &stats);
+std::vector<int> findShortestPathBranchAndBound(const DistanceMatrix &dist,
+                                                SearchStats &stats);
+std::vector<int> findShortestPathParallel(const DistanceMatrix &dist,
+                                          int numThreads, SearchStats &stats);
+std::vector<int> findShortestPathIncremental(const DistanceMatrix &dist,
+                                             SearchStats &stats);
+
+//Solver names accepted by solveExact: brute, heldkarp, bnb, parallel,
+//incremental
+bool isExactSolverName(const std::string &solver);
+
+//Builds the distance matrix and runs the named solver. Returns an empty
+//order when the instance is too large for heldkarp.
+std::vector<int> solveExact(const std::string &solver,
+                            const std::vector<Point> &points,
+                            int numThreads, SearchStats &stats);
+
+#endif
@@ -0,0 +1,135 @@
+#include "tsp-io.hh"
+#include "PointCloud.hh"
+#include "parallel.hh"
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cerrno>
+#include <dirent.h>
+#include <sys/stat.h>
+
+using namespace std;
+
+bool readPointFile(const string &path, vector<Point> &points, string &error) {
+
+	//Slurp the file; one read beats thousands of formatted extractions
+	ifstream in(path.c_str(), ios::in | ios::binary);
+	if (!in) {
+		error = "cannot open file";
+		return false;
+	}
+	string text((istreambuf_iterator<char>(in)), istreambuf_iterator<char>());
+
+	const char *cur = text.c_str();
+	char *end;
+	errno = 0;
+	long count = strtol(cur, &end, 10);
+	if (end == cur || count < 0 || errno) {
+		error = "missing point count";
+		return false;
+	}
+	cur = end;
+
+	//The count is untrusted; every point takes at least six characters,
+	//so never reserve more than the text could hold
+	points.clear();
+	points.reserve(min(count, (long) text.size() / 6));
+	for (long i = 0; i < count; i++) {
+		double coords[3];
+		for (int c = 0; c < 3; c++) {
+			coords[c] = strtod(cur, &end);
+			if (end == cur) {
+				error = "expected " + to_string(count) + " points, read " +
+				        to_string(i);
+				return false;
+			}
+			cur = end;
+		}
+		points.push_back(Point(coords[0], coords[1], coords[2]));
+	}
+	return true;
+}
+
+static bool hasSuffix(const string &s, const string &suffix) {
+	return s.size() >= suffix.size() &&
+	       s.compare(s.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+vector<string> listInstanceFiles(const vector<string> &args) {
+	vector<string> files;
+	for (const string &arg : args) {
+		struct stat info;
+		if (stat(arg.c_str(), &info) != 0 || !S_ISDIR(info.st_mode)) {
+			files.push_back(arg);
+			continue;
+		}
+
+		//Directory: take its *.txt entries in name order
+		vector<string> entries;
+		DIR *dir = opendir(arg.c_str());
+		if (!dir) continue;
+		for (struct dirent *e = readdir(dir); e; e = readdir(dir)) {
+			string name = e->d_name;
+			if (hasSuffix(name, ".txt")) entries.push_back(name);
+		}
+		closedir(dir);
+		sort(entries.begin(), entries.end());
+
+		string prefix = hasSuffix(arg, "/") ? arg : arg + "/";
+		for (const string &name : entries) files.push_back(prefix + name);
+	}
+	return files;
+}
+
+int runBatch(const vector<string> &paths, int numThreads,
+             const BatchSolver &solve, ostream &out) {
+
+	//Each worker formats its own line; lines are printed in input order
+	vector<string> lines(paths.size());
+	vector<char> failed(paths.size(), false);
+
+	parallelFor((int) paths.size(), numThreads, [&](int task, int) {
+		ostringstream line;
+		line << paths[task] << "\t";
+
+		vector<Point> points;
+		string error;
+		if (!readPointFile(paths[task], points, error)) {
+			line << "error\t" << error;
+			failed[task] = true;
+		} else if (points.empty()) {
+			line << "error\tno points";
+			failed[task] = true;
+		} else {
+			chrono::steady_clock::time_point start = chrono::steady_clock::now();
+			vector<int> order = solve(points);
+			chrono::duration<double> elapsed = chrono::steady_clock::now() - start;
+
+			if (order.size() != points.size()) {
+				line << "error\tsolver declined instance";
+				failed[task] = true;
+			} else {
+				PointCloud cloud(points);
+				line << points.size() << "\t" << setprecision(10)
+				     << cloud.tourLength(order.data(), (int) order.size()) << "\t"
+				     << setprecision(6) << elapsed.count() << "\t";
+				for (unsigned int i = 0; i < order.size(); i++) {
+					line << (i ? "," : "") << order[i];
+				}
+			}
+		}
+		lines[task] = line.str();
+	});
+
+	int numFailed = 0;
+	out << "#path\tpoints\tlength\tseconds\ttour" << endl;
+	for (unsigned int i = 0; i < lines.size(); i++) {
+		out << lines[i] << "\n";
+		if (failed[i]) numFailed++;
+	}
+	out.flush();
+	return numFailed;
+}
@@ -0,0 +1,31 @@
+//Header file for reading TSP instance files and solving them in batches
+#ifndef TSP_IO_HH
+#define TSP_IO_HH
+
+#include <vector>
+#include <string>
+#include <ostream>
+#include <functional>
+#include "Point.hh"
+
+//Reads an instance in the tests/test-*.txt format: a point count, then
+//"x y z" for each point, whitespace separated. The whole file is read in
+//one go and parsed with strtod. Returns false and sets error on failure.
+bool readPointFile(const std::string &path, std::vector<Point> &points,
+                   std::string &error);
+
+//Expands the given files and directories into a sorted list of instance
+//files; directories contribute every *.txt file directly inside them.
+std::vector<std::string> listInstanceFiles(const std::vector<std::string> &args);
+
+//Solves one instance and returns the visiting order
+typedef std::function<std::vector<int>(const std::vector<Point> &)> BatchSolver;
+
+//Solves every file on numThreads workers and writes one tab-separated line
+//per instance, in input order: path, points, length, seconds, tour (comma
+//separated), or path followed by "error" and a message. Returns the number
+//of instances that failed.
+int runBatch(const std::vector<std::string> &paths, int numThreads,
+             const BatchSolver &solve, std::ostream &out);
+
+#endif
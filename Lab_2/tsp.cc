@@ -1,15 +1,55 @@
 #include <iostream>
 #include <vector>
-#include <algorithm>
-#include "Point.hh"
+#include <string>
+#include <cstdlib>
+#include "tsp-exact.hh"
+#include "tsp-io.hh"
+#include "parallel.hh"
 
 using namespace std;
 
 double circuitLength(const vector<Point> &points, const vector<int> &order);
-vector<int> findShortestPath(const vector<Point> &points);
 void displayPath(const vector<int> &order);
+void usage(const char *progname);
+
+int main(int argc, char **argv) {
+
+	//Pick the solver: plain permutation search unless told otherwise.
+	//Anything after --batch is an instance file or directory.
+	string solver = "brute";
+	vector<string> batchArgs;
+	int numThreads = defaultThreadCount();
+	bool batch = false;
+	for (int i = 1; i < argc; i++) {
+		string arg = argv[i];
+		if (arg == "--threads" && i + 1 < argc) {
+			numThreads = atoi(argv[++i]);
+		} else if (arg == "--batch") {
+			batch = true;
+		} else if (batch) {
+			batchArgs.push_back(arg);
+		} else if (i == 1) {
+			solver = arg;
+		} else {
+			usage(argv[0]);
+			return 1;
+		}
+	}
+	if (!isExactSolverName(solver) || numThreads < 1 || (batch && batchArgs.empty())) {
+		usage(argv[0]);
+		return 1;
+	}
 
-int main() {
+	//Batch mode: instances run concurrently, each solver single-threaded
+	if (batch) {
+		vector<string> files = listInstanceFiles(batchArgs);
+		int failed = runBatch(files, numThreads,
+			[&](const vector<Point> &points) {
+				SearchStats stats;
+				return solveExact(solver, points, 1, stats);
+			}, cout);
+		return failed ? 1 : 0;
+	}
 
 	//Variables to hold user input points
 	int nPoints;
@@ -34,14 +74,25 @@ int main() {
 		cout << endl;
 	}
 
+	if (solver == "heldkarp" && nPoints > HELD_KARP_MAX_POINTS) {
+		cout << "heldkarp supports at most " << HELD_KARP_MAX_POINTS
+				 << " points." << endl;
+		return 1;
+	}
+
 	//Find shortest path and output the result
-	vector<int> bestPath;
-	bestPath = findShortestPath(usrPoints);
+	SearchStats stats;
+	vector<int> bestPath = solveExact(solver, usrPoints, numThreads, stats);
 	displayPath(bestPath);
 
 	//Display its length
 	cout << "Shortest distance: " << circuitLength(usrPoints, bestPath) << endl; 
 
+	if (solver == "bnb") {
+		cout << "Nodes explored: " << stats.nodes << ", pruned: " << stats.pruned
+				 << " (root 1-tree bound " << stats.rootBound << ")" << endl;
+	}
+
 	return 0;
 }
 
@@ -62,29 +113,6 @@ double circuitLength(const vector<Point> &points, const vector<int> &order) {
 	return cumuLength;
 }
 
-vector<int> findShortestPath(const vector<Point> &points) {
-	
-	//Path to be permuted and iterated over
-	vector<int> curPath;
-	for (unsigned int i = 0; i < points.size(); i++) curPath.push_back((int) i);
-
-	//Holds best found path so far and its length
-	double shortestLength = circuitLength(points, curPath);
-	vector<int> bestPath = curPath;
-	double curLength = 0;
-
-	//Iterate over all possible paths and record the best path
-	while (next_permutation(curPath.begin(),curPath.end())) {
-		curLength = circuitLength(points, curPath);
-		if (curLength < shortestLength) {
-			shortestLength = curLength;
-			bestPath = curPath;
-		}
-	}
-
-	return bestPath;
-}
-
 void displayPath(const vector<int> &order) {
 
 	//Iterate over given vector and display each element
@@ -95,19 +123,20 @@ void displayPath(const vector<int> &order) {
 	cout << order.back() << "]" << endl;
 }
 
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
+void usage(const char *progname) {
+	cout << "Usage: " << progname << " [solver] [--threads N]"
+			 << " [--batch file|dir ...]" << endl;
+	cout << "\nsolver: brute (default) - try every permutation, O(n!)" << endl;
+	cout << "        heldkarp - bitmask dynamic programming, O(2^n n^2),"
+			 << " up to " << HELD_KARP_MAX_POINTS << " points" << endl;
+	cout << "        bnb - branch and bound with 1-tree lower bounds" << endl;
+	cout << "        parallel - permutation search split by tour prefix"
+			 << " across all cores" << endl;
+	cout << "        incremental - each tour in one direction only, by single"
+			 << " swaps, O(1) length update each" << endl;
+	cout << "\n--threads: worker threads (default: all cores)" << endl;
+	cout << "--batch: solve instance files (directories: every *.txt inside)"
+			 << " concurrently," << endl;
+	cout << "         printing one tab-separated result line per instance"
+			 << endl;
+}
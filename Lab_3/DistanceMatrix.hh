@@ -0,0 +1,91 @@
+//Precomputed pairwise distances between the points of a TSP instance
+#ifndef DISTANCE_MATRIX_HH
+#define DISTANCE_MATRIX_HH
+
+#include <vector>
+#include <cstddef>
+#include <algorithm>
+#include "Point.hh"
+#include "PointCloud.hh"
+#include "parallel.hh"
+
+//Tables larger than this many bytes are not built; distances are then
+//computed from the coordinates on every lookup instead.
+const size_t DISTANCE_MATRIX_DEFAULT_BUDGET = (size_t) 1 << 30;
+
+//Distances are symmetric, so only the lower triangle (diagonal included)
+//is stored: entry (i, j) with j <= i lives at i*(i+1)/2 + j. T is the
+//storage type; float halves the footprint at the cost of ~7 digits.
+template <typename T>
+class BasicDistanceMatrix {
+	private:
+		int _n;
+		bool _precomputed;
+		std::vector<T> _table;
+		PointCloud _cloud;       //coordinates for on-the-fly mode
+
+		static size_t rowStart(int i) {
+			return (size_t) i * (i + 1) / 2;
+		}
+
+	public:
+		//Constructor
+		BasicDistanceMatrix(const std::vector<Point> &points, int numThreads = 1,
+		                    size_t memoryBudget = DISTANCE_MATRIX_DEFAULT_BUDGET)
+				: _n((int) points.size()), _cloud(points) {
+
+			_precomputed = rowStart(_n) * sizeof(T) <= memoryBudget;
+			if (!_precomputed) return;
+
+			//Row i costs i+1 entries; interleave rows from both ends so
+			//each task is about the same size
+			_table.resize(rowStart(_n));
+			parallelFor((_n + 1) / 2, numThreads, [&](int task, int) {
+				std::vector<double> buffer(_n);
+				int rows[2] = { task, _n - 1 - task };
+				for (int r = 0; r < 2; r++) {
+					int i = rows[r];
+					if (r == 1 && i == task) break;
+					_cloud.distancesFrom(i, 0, i + 1, buffer.data());
+					T *row = &_table[rowStart(i)];
+					for (int j = 0; j <= i; j++) row[j] = (T) buffer[j];
+				}
+			});
+		}
+
+		//Accessor methods
+		inline int size() const {
+			return _n;
+		}
+
+		inline bool isPrecomputed() const {
+			return _precomputed;
+		}
+
+		inline double operator()(int i, int j) const {
+			if (!_precomputed) return _cloud.distance(i, j);
+			if (i < j) std::swap(i, j);
+			return _table[rowStart(i) + j];
+		}
+
+		inline const PointCloud &cloud() const {
+			return _cloud;
+		}
+
+		//Length of the closed circuit visiting order[0..n-1]. Whole tours
+		//go through the vectorised PointCloud kernel even when the table
+		//exists: recomputing from coordinates held in L1 beats the
+		//triangular index arithmetic per edge.
+		double tourLength(const int *order, int n) const {
+			return _cloud.tourLength(order, n);
+		}
+
+		double tourLength(const std::vector<int> &order) const {
+			return tourLength(order.data(), (int) order.size());
+		}
+};
+
+typedef BasicDistanceMatrix<double> DistanceMatrix;
+typedef BasicDistanceMatrix<float> FloatDistanceMatrix;
+
+#endif
@@ -0,0 +1,175 @@
+#include "KdTree.hh"
+#include "parallel.hh"
+#include <algorithm>
+
+using namespace std;
+
+//Constructors
+KdTree::KdTree(const vector<Point> &points, int numThreads)
+		: _n((int) points.size()) {
+	vector<double> coords(3 * (size_t) _n);
+	double *xs = coords.data(), *ys = xs + _n, *zs = ys + _n;
+	for (int i = 0; i < _n; i++) {
+		xs[i] = points[i].getX();
+		ys[i] = points[i].getY();
+		zs[i] = points[i].getZ();
+	}
+	build(xs, ys, zs, numThreads);
+}
+
+KdTree::KdTree(const PointCloud &cloud, int numThreads) : _n(cloud.size()) {
+	build(cloud.xs(), cloud.ys(), cloud.zs(), numThreads);
+}
+
+void KdTree::build(const double *xs, const double *ys, const double *zs,
+                   int numThreads) {
+	_index.resize(_n);
+	_axis.assign(_n, 0);
+	for (int i = 0; i < _n; i++) _index[i] = i;
+	const double *coords[3] = { xs, ys, zs };
+
+	//Split the top levels here until there are a few ranges per thread,
+	//then build those subtrees concurrently; they touch disjoint slots
+	vector<pair<int, int> > ranges(1, make_pair(0, _n));
+	while ((int) ranges.size() < 4 * numThreads) {
+		vector<pair<int, int> > next;
+		for (const pair<int, int> &r : ranges) {
+			if (r.second - r.first <= 4 * KDTREE_LEAF_SIZE) {
+				next.push_back(r);
+				continue;
+			}
+			buildRange(coords, r.first, r.second);
+			int mid = r.first + (r.second - r.first) / 2;
+			next.push_back(make_pair(r.first, mid));
+			next.push_back(make_pair(mid + 1, r.second));
+		}
+		if (next.size() == ranges.size()) break;
+		ranges.swap(next);
+	}
+	parallelFor((int) ranges.size(), numThreads, [&](int t, int) {
+		const int lo = ranges[t].first, hi = ranges[t].second;
+
+		//Depth-first over the subtree with an explicit stack
+		vector<pair<int, int> > stack(1, make_pair(lo, hi));
+		while (!stack.empty()) {
+			pair<int, int> r = stack.back();
+			stack.pop_back();
+			if (r.second - r.first <= KDTREE_LEAF_SIZE) continue;
+			buildRange(coords, r.first, r.second);
+			int mid = r.first + (r.second - r.first) / 2;
+			stack.push_back(make_pair(r.first, mid));
+			stack.push_back(make_pair(mid + 1, r.second));
+		}
+	});
+
+	_xyz.resize(3 * (size_t) _n);
+	_slot.resize(_n);
+	for (int s = 0; s < _n; s++) {
+		_slot[_index[s]] = s;
+		for (int a = 0; a < 3; a++) _xyz[3 * (size_t) s + a] = coords[a][_index[s]];
+	}
+}
+
+//Chooses the node's axis and partitions [lo, hi) around its middle slot
+void KdTree::buildRange(const double *coords[3], int lo, int hi) {
+	int axis = 0;
+	double widest = -1;
+	for (int a = 0; a < 3; a++) {
+		double low = coords[a][_index[lo]], high = low;
+		for (int s = lo + 1; s < hi; s++) {
+			double c = coords[a][_index[s]];
+			low = min(low, c);
+			high = max(high, c);
+		}
+		if (high - low > widest) {
+			widest = high - low;
+			axis = a;
+		}
+	}
+	const double *c = coords[axis];
+	int mid = lo + (hi - lo) / 2;
+	nth_element(_index.begin() + lo, _index.begin() + mid, _index.begin() + hi,
+	            [&](int i, int j) { return c[i] < c[j] || (c[i] == c[j] && i < j); });
+	_axis[mid] = (unsigned char) axis;
+}
+
+void KdTree::searchNearest(int lo, int hi, const double q[3], size_t k,
+                           int skip, vector<Candidate> &heap) const {
+	auto consider = [&](int s) {
+		if (_index[s] == skip) return;
+		Candidate c(distance2(s, q), _index[s]);
+		if (heap.size() < k) {
+			heap.push_back(c);
+			push_heap(heap.begin(), heap.end());
+		} else if (c < heap.front()) {
+			pop_heap(heap.begin(), heap.end());
+			heap.back() = c;
+			push_heap(heap.begin(), heap.end());
+		}
+	};
+
+	if (hi - lo <= KDTREE_LEAF_SIZE) {
+		for (int s = lo; s < hi; s++) consider(s);
+		return;
+	}
+	int mid = lo + (hi - lo) / 2;
+	int axis = _axis[mid];
+	double diff = q[axis] - _xyz[3 * (size_t) mid + axis];
+	consider(mid);
+
+	//Nearer side first; the far side only if the split plane is closer
+	//than the current k-th best
+	if (diff < 0) searchNearest(lo, mid, q, k, skip, heap);
+	else searchNearest(mid + 1, hi, q, k, skip, heap);
+	if (heap.size() < k || diff * diff <= heap.front().first) {
+		if (diff < 0) searchNearest(mid + 1, hi, q, k, skip, heap);
+		else searchNearest(lo, mid, q, k, skip, heap);
+	}
+}
+
+void KdTree::searchRadius(int lo, int hi, const double q[3], double r2,
+                          vector<Candidate> &found) const {
+	if (hi - lo <= KDTREE_LEAF_SIZE) {
+		for (int s = lo; s < hi; s++) {
+			double d2 = distance2(s, q);
+			if (d2 <= r2) found.push_back(Candidate(d2, _index[s]));
+		}
+		return;
+	}
+	int mid = lo + (hi - lo) / 2;
+	int axis = _axis[mid];
+	double diff = q[axis] - _xyz[3 * (size_t) mid + axis];
+	double d2 = distance2(mid, q);
+	if (d2 <= r2) found.push_back(Candidate(d2, _index[mid]));
+	if (diff < 0 || diff * diff <= r2) searchRadius(lo, mid, q, r2, found);
+	if (diff >= 0 || diff * diff <= r2) searchRadius(mid + 1, hi, q, r2, found);
+}
+
+//Member functions
+void KdTree::nearest(double x, double y, double z, int k,
+                     vector<int> &result, int skip) const {
+	result.clear();
+	if (k <= 0 || _n == 0) return;
+	const double q[3] = { x, y, z };
+	vector<Candidate> heap;
+	heap.reserve(k);
+	searchNearest(0, _n, q, (size_t) k, skip, heap);
+	sort_heap(heap.begin(), heap.end());
+	for (const Candidate &c : heap) result.push_back(c.second);
+}
+
+void KdTree::nearest(int i, int k, vector<int> &result) const {
+	const double *p = &_xyz[3 * (size_t) _slot[i]];
+	nearest(p[0], p[1], p[2], k, result, i);
+}
+
+void KdTree::withinRadius(double x, double y, double z, double radius,
+                          vector<int> &result) const {
+	result.clear();
+	if (_n == 0 || radius < 0) return;
+	const double q[3] = { x, y, z };
+	vector<Candidate> found;
+	searchRadius(0, _n, q, radius * radius, found);
+	sort(found.begin(), found.end());
+	for (const Candidate &c : found) result.push_back(c.second);
+}
@@ -0,0 +1,71 @@
+//3D kd-tree for nearest-neighbour and radius queries over a point set
+#ifndef KDTREE_HH
+#define KDTREE_HH
+
+#include <vector>
+#include <utility>
+#include <cstddef>
+#include "Point.hh"
+#include "PointCloud.hh"
+
+//Ranges of at most this many points are scanned instead of split
+const int KDTREE_LEAF_SIZE = 8;
+
+//Implicit, balanced tree: the point indices are permuted so that every
+//node covers a contiguous range with its splitting point at the middle,
+//points before it on the low side of the split plane and points after it
+//on the high side. Each node splits along the axis where its points
+//spread widest. Coordinates are copied in tree order, so a query walks
+//memory front to back. Building is O(n log n) with one nth_element per
+//level; with numThreads > 1 the subtrees below the top levels are built
+//in parallel. Queries are const and safe from any number of threads.
+class KdTree {
+	private:
+		int _n;
+		std::vector<int> _index;            //point index at each tree slot
+		std::vector<int> _slot;             //and the slot of each point
+		std::vector<double> _xyz;           //coordinates by tree slot
+		std::vector<unsigned char> _axis;   //split axis of the node at slot
+
+		typedef std::pair<double, int> Candidate;   //squared distance, index
+
+		void build(const double *xs, const double *ys, const double *zs,
+		           int numThreads);
+		void buildRange(const double *coords[3], int lo, int hi);
+		void searchNearest(int lo, int hi, const double q[3], size_t k,
+		                   int skip, std::vector<Candidate> &heap) const;
+		void searchRadius(int lo, int hi, const double q[3], double r2,
+		                  std::vector<Candidate> &found) const;
+
+		inline double distance2(int slot, const double q[3]) const {
+			const double *p = &_xyz[3 * (size_t) slot];
+			double dx = p[0] - q[0], dy = p[1] - q[1], dz = p[2] - q[2];
+			return dx * dx + dy * dy + dz * dz;
+		}
+
+	public:
+		//Constructors
+		KdTree(const std::vector<Point> &points, int numThreads = 1);
+		KdTree(const PointCloud &cloud, int numThreads = 1);
+
+		//Accessor methods
+		inline int size() const {
+			return _n;
+		}
+
+		//Member functions
+
+		//Indices of the k points nearest (x, y, z), nearest first, with
+		//ties broken by index; skip (if not -1) is left out
+		void nearest(double x, double y, double z, int k,
+		             std::vector<int> &result, int skip = -1) const;
+
+		//The k nearest other points to point i
+		void nearest(int i, int k, std::vector<int> &result) const;
+
+		//Indices of all points within radius of (x, y, z), nearest first
+		void withinRadius(double x, double y, double z, double radius,
+		                  std::vector<int> &result) const;
+};
+
+#endif
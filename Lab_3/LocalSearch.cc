@@ -0,0 +1,351 @@
+#include "LocalSearch.hh"
+#include "parallel.hh"
+#include "KdTree.hh"
+#include <algorithm>
+#include <iostream>
+#include <cmath>
+#include <cstdlib>
+
+using namespace std;
+
+//Moves must gain at least this much, so rounding never makes us cycle
+const double IMPROVEMENT_EPS = 1e-9;
+
+//Most flips in one Lin-Kernighan step
+const int LIN_KERNIGHAN_DEPTH = 10;
+
+namespace {
+
+//A tour as city array plus position array. Reversals flip whichever side
+//of the cycle is shorter, so "forward" is not stable across moves; every
+//move is therefore stated in terms of cities and adjacency.
+struct Tour {
+	int *order;
+	int *pos;
+	int n;
+
+	inline int succ(int c) const {
+		int i = pos[c] + 1;
+		return order[i == n ? 0 : i];
+	}
+
+	inline int pred(int c) const {
+		int i = pos[c];
+		return order[i == 0 ? n - 1 : i - 1];
+	}
+
+	//Reverses positions i..j going forward around the cycle
+	void reverse(int i, int j) {
+		int len = j - i;
+		if (len < 0) len += n;
+		len++;
+		if (2 * len > n) {
+			int from = j + 1 == n ? 0 : j + 1;
+			j = i == 0 ? n - 1 : i - 1;
+			i = from;
+			len = n - len;
+		}
+		for (int k = 0; k < len / 2; k++) {
+			swap(order[i], order[j]);
+			pos[order[i]] = i;
+			pos[order[j]] = j;
+			i = i + 1 == n ? 0 : i + 1;
+			j = j == 0 ? n - 1 : j - 1;
+		}
+	}
+
+	//Replaces edges (a, b) and (c, d) with (a, c) and (b, d), where b
+	//follows a in the same direction as d follows c
+	void move2opt(int a, int b, int c, int d) {
+		if (succ(a) == b) reverse(pos[b], pos[c]);
+		else reverse(pos[a], pos[d]);
+	}
+};
+
+//Cities whose don't-look bit is clear, in FIFO order. A city leaves the
+//queue when it is examined and comes back when one of its tour edges
+//changes.
+struct ActiveQueue {
+	LocalSearchScratch &s;
+	int n, head, tail, count;
+
+	inline void push(int city) {
+		if (s.queued[city]) return;
+		s.queued[city] = 1;
+		s.queue[tail] = city;
+		tail = tail + 1 == n ? 0 : tail + 1;
+		count++;
+	}
+
+	inline int pop() {
+		int city = s.queue[head];
+		head = head + 1 == n ? 0 : head + 1;
+		count--;
+		s.queued[city] = 0;
+		return city;
+	}
+};
+
+//2-opt: add edge (a, c) for a neighbour c closer than a's current
+//successor (or predecessor) b, and close up with (b, d). Applies the
+//first improving move and returns its (negative) delta, or 0.
+double tryTwoOpt(Tour &tour, ActiveQueue &active, const LocalSearch &search,
+                 const DistanceMatrix &dist, int a) {
+	const int k = search.numNeighbours();
+	const int *near = search.neighbours(a);
+	for (int dir = 0; dir < 2; dir++) {
+		int b = dir ? tour.pred(a) : tour.succ(a);
+		double dab = dist(a, b);
+		for (int m = 0; m < k; m++) {
+			int c = near[m];
+			double dac = dist(a, c);
+			if (dac >= dab) break;
+			int d = dir ? tour.pred(c) : tour.succ(c);
+			if (c == b || d == a) continue;
+			double delta = dac + dist(b, d) - dab - dist(c, d);
+			if (delta < -IMPROVEMENT_EPS) {
+				tour.move2opt(a, b, c, d);
+				active.push(a);
+				active.push(b);
+				active.push(c);
+				active.push(d);
+				return delta;
+			}
+		}
+	}
+	return 0;
+}
+
+//Or-opt: cut out the segment s1..s2 of 1-3 cities starting at a and
+//reinsert it, either way round, next to a neighbour of an end. Applies
+//the first improving move and returns its delta, or 0.
+double tryOrOpt(Tour &tour, ActiveQueue &active, const LocalSearch &search,
+                const DistanceMatrix &dist, int a) {
+	const int k = search.numNeighbours();
+	const int n = tour.n;
+	int s1 = a, s2 = a;
+	for (int len = 1; len <= 3; len++) {
+		if (len > 1) s2 = tour.succ(s2);
+		int p = tour.pred(s1), nx = tour.succ(s2);
+		double removeGain = dist(p, s1) + dist(s2, nx) - dist(p, nx);
+		if (removeGain <= IMPROVEMENT_EPS) continue;
+		const int start = tour.pos[s1];
+
+		for (int end = 0; end < 2; end++) {
+			int s = end ? s2 : s1;
+			const int *near = search.neighbours(s);
+			for (int m = 0; m < k; m++) {
+				int c = near[m];
+				if (dist(s, c) >= removeGain) break;
+
+				//Insert between (c, succ c) or (pred c, c), neither in the segment
+				for (int side = 0; side < 2; side++) {
+					int x = side ? tour.pred(c) : c;
+					int y = side ? c : tour.succ(c);
+					int offX = tour.pos[x] - start, offY = tour.pos[y] - start;
+					if (offX < 0) offX += n;
+					if (offY < 0) offY += n;
+					if (offX < len || offY < len) continue;
+
+					double dxy = dist(x, y);
+					double addForward = dist(x, s1) + dist(s2, y) - dxy;
+					double addReversed = dist(x, s2) + dist(s1, y) - dxy;
+					bool reversed = addReversed < addForward;
+					double delta = (reversed ? addReversed : addForward) - removeGain;
+					if (delta >= -IMPROVEMENT_EPS) continue;
+
+					//Three 2-opt moves: p-x ... s1-y, then p-nx ... x-s2 leaves the
+					//segment reversed between x and y; the last flips it back
+					tour.move2opt(p, s1, x, y);
+					tour.move2opt(p, x, nx, s2);
+					if (!reversed && len > 1) tour.move2opt(x, s2, s1, y);
+					active.push(p);
+					active.push(nx);
+					active.push(s1);
+					active.push(s2);
+					active.push(x);
+					active.push(y);
+					return delta;
+				}
+			}
+		}
+	}
+	return 0;
+}
+
+//Whether {u, v} is one of the count edges stored as pairs in edges
+inline bool edgeIn(const int *edges, int count, int u, int v) {
+	for (int i = 0; i < count; i++) {
+		int a = edges[2 * i], b = edges[2 * i + 1];
+		if ((a == u && b == v) || (a == v && b == u)) return true;
+	}
+	return false;
+}
+
+//Lin-Kernighan step from t1, built from 2-opt flips. Edge (t1, t2) is
+//opened; each level adds (t2, t3) for a neighbour t3 and breaks (t3, t4)
+//so that flipping closes the tour with (t1, t4), then continues from
+//t4 as the new t2. The chain goes on while the running gain stays
+//positive, up to maxDepth flips, and is cut back to its best closed
+//tour. Removed edges are never re-added and added ones never removed.
+//The first level tries every candidate t3, deeper levels take the one
+//maximising d(t3, t4) - d(t2, t3). Returns the delta, or 0 with the tour
+//unchanged.
+double tryLinKernighan(Tour &tour, ActiveQueue &active,
+                       const LocalSearch &search, const DistanceMatrix &dist,
+                       int t1, int maxDepth, LocalSearchScratch &scratch) {
+	const int k = search.numNeighbours();
+	if ((int) scratch.flips.size() < 4 * maxDepth) {
+		scratch.flips.resize(4 * maxDepth);
+		scratch.added.resize(2 * maxDepth);
+		scratch.removed.resize(2 * (maxDepth + 1));
+	}
+	int *flips = scratch.flips.data();
+	int *added = scratch.added.data(), *removed = scratch.removed.data();
+
+	for (int dir = 0; dir < 2; dir++) {
+		const int t2 = dir ? tour.pred(t1) : tour.succ(t1);
+		for (int first = 0; first < k; first++) {
+			if (dist(t1, t2) - dist(t2, search.neighbours(t2)[first]) <=
+			    IMPROVEMENT_EPS) {
+				break;
+			}
+			double gain = dist(t1, t2), bestGain = 0;
+			int numFlips = 0, bestFlips = 0;
+			removed[0] = t1;
+			removed[1] = t2;
+			int cur = t2;
+
+			while (numFlips < maxDepth) {
+
+				//t4 lies on the same side of t3 as t1 does of cur
+				const bool forward = tour.succ(cur) == t1;
+				const int *near = search.neighbours(cur);
+				int t3 = -1, t4 = -1;
+				double bestScore = 0;
+				for (int m = numFlips == 0 ? first : 0; m < k; m++) {
+					int c = near[m];
+					double g1 = gain - dist(cur, c);
+					if (g1 <= IMPROVEMENT_EPS) break;
+					int d = forward ? tour.succ(c) : tour.pred(c);
+					if (c == t1 || d == cur || c == tour.succ(cur) ||
+					    c == tour.pred(cur)) {
+						if (numFlips == 0) break;
+						continue;
+					}
+					if (edgeIn(added, numFlips, c, d) ||
+					    edgeIn(removed, numFlips + 1, cur, c)) {
+						if (numFlips == 0) break;
+						continue;
+					}
+					double score = dist(c, d) - dist(cur, c);
+					if (t3 < 0 || score > bestScore) {
+						t3 = c;
+						t4 = d;
+						bestScore = score;
+					}
+					if (numFlips == 0) break;
+				}
+				if (t3 < 0) break;
+
+				tour.move2opt(cur, t1, t3, t4);
+				int *f = flips + 4 * numFlips;
+				f[0] = cur; f[1] = t1; f[2] = t3; f[3] = t4;
+				added[2 * numFlips] = cur;
+				added[2 * numFlips + 1] = t3;
+				numFlips++;
+				removed[2 * numFlips] = t3;
+				removed[2 * numFlips + 1] = t4;
+
+				gain += dist(t3, t4) - dist(cur, t3);
+				double closed = gain - dist(t4, t1);
+				if (closed > bestGain + IMPROVEMENT_EPS) {
+					bestGain = closed;
+					bestFlips = numFlips;
+				}
+				cur = t4;
+			}
+
+			//Undo the flips past the best point, newest first
+			for (int i = numFlips - 1; i >= bestFlips; i--) {
+				const int *f = flips + 4 * i;
+				tour.move2opt(f[0], f[2], f[1], f[3]);
+			}
+			if (bestFlips > 0) {
+				for (int i = 0; i < 4 * bestFlips; i++) active.push(flips[i]);
+				return -bestGain;
+			}
+		}
+	}
+	return 0;
+}
+
+}
+
+LocalSearch::LocalSearch(const DistanceMatrix &dist, int numNeighbours,
+                         int numThreads, LocalSearchMoves moves)
+		: _dist(dist), _moves(moves), _maxDepth(LIN_KERNIGHAN_DEPTH) {
+	const int n = dist.size();
+	_numNeighbours = max(0, min(numNeighbours, n - 1));
+	_neighbours.resize((size_t) n * _numNeighbours);
+	if (_numNeighbours == 0) return;
+
+	//k + 1 nearest by kd-tree query, minus the city itself
+	KdTree tree(dist.cloud(), numThreads);
+	vector<vector<int> > found(max(1, numThreads));
+	parallelFor(n, numThreads, [&](int i, int thread) {
+		tree.nearest(i, _numNeighbours, found[thread]);
+		copy(found[thread].begin(), found[thread].end(),
+		     _neighbours.begin() + (size_t) i * _numNeighbours);
+	});
+}
+
+double LocalSearch::improve(int *order, int numPoints, double length,
+                            LocalSearchScratch &scratch) const {
+
+	//Small tours have too few distinct edges for the moves below
+	const int n = numPoints;
+	if (n < 8 || _numNeighbours == 0) return length;
+
+	scratch.pos.resize(n);
+	scratch.queue.resize(n);
+	scratch.queued.assign(n, 1);
+	Tour tour = { order, scratch.pos.data(), n };
+	for (int i = 0; i < n; i++) {
+		tour.pos[order[i]] = i;
+		scratch.queue[i] = order[i];
+	}
+	ActiveQueue active = { scratch, n, 0, 0, n };
+	const DistanceMatrix &dist = _dist;
+
+	while (active.count > 0) {
+		int a = active.pop();
+		double delta;
+		if (_moves == MOVES_LIN_KERNIGHAN) {
+			delta = tryLinKernighan(tour, active, *this, dist, a, _maxDepth,
+			                        scratch);
+		} else {
+			delta = tryTwoOpt(tour, active, *this, dist, a);
+		}
+		if (delta == 0) delta = tryOrOpt(tour, active, *this, dist, a);
+		length += delta;
+	}
+
+#ifdef TSP_GA_CHECK_DELTAS
+	double full = dist.tourLength(order, n);
+	if (fabs(full - length) > 1e-9 * max(1.0, full)) {
+		cerr << "LocalSearch::improve: incremental length " << length
+		     << " but full recomputation gives " << full << endl;
+		abort();
+	}
+#endif
+	return length;
+}
+
+double improveTour(vector<int> &tour, const DistanceMatrix &dist,
+                   int numNeighbours, int numThreads) {
+	LocalSearch search(dist, numNeighbours, numThreads, MOVES_LIN_KERNIGHAN);
+	LocalSearchScratch scratch;
+	return search.improve(tour.data(), (int) tour.size(),
+	                      dist.tourLength(tour), scratch);
+}
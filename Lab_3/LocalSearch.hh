@@ -0,0 +1,74 @@
+//2-opt and Or-opt improvement of tours over nearest-neighbour lists
+#ifndef LOCALSEARCH_HH
+#define LOCALSEARCH_HH
+
+#include <vector>
+#include "DistanceMatrix.hh"
+
+//Per-thread working storage for LocalSearch::improve, sized on first
+//use and reused afterwards
+struct LocalSearchScratch {
+	std::vector<int> pos;       //position of each city in the tour
+	std::vector<int> queue;     //ring buffer of cities still to examine
+	std::vector<char> queued;   //cleared bit = don't look at this city
+	std::vector<int> flips;     //Lin-Kernighan: the current chain of flips
+	std::vector<int> added, removed;
+};
+
+//Improving moves tried around each city before Or-opt:
+//  MOVES_2OPT          - a single 2-opt move
+//  MOVES_LIN_KERNIGHAN - a Lin-Kernighan chain of up to ten 2-opt flips,
+//                        kept at its best prefix (which covers 3-opt
+//                        and deeper sequential moves)
+enum LocalSearchMoves {
+	MOVES_2OPT,
+	MOVES_LIN_KERNIGHAN
+};
+
+//Holds the k nearest neighbours of every city, over an array tour with
+//a position index. improve() only tries moves that add an edge from a
+//city to one of its neighbours, and keeps
+//a queue of "active" cities (the complement of don't-look bits): a city
+//leaves the queue when no move around it helps and comes back when one
+//of its tour edges changes. The object is read-only once built, so any
+//number of threads can share it, each with its own scratch.
+class LocalSearch {
+	private:
+		const DistanceMatrix &_dist;
+		LocalSearchMoves _moves;
+		int _maxDepth;
+		int _numNeighbours;
+		std::vector<int> _neighbours;   //row per city, nearest first
+
+	public:
+		//Constructor; the neighbour lists come from a kd-tree over the
+		//matrix's points, built and queried on numThreads threads
+		LocalSearch(const DistanceMatrix &dist, int numNeighbours,
+		            int numThreads, LocalSearchMoves moves = MOVES_2OPT);
+
+		//Accessor methods
+		inline int numNeighbours() const {
+			return _numNeighbours;
+		}
+
+		inline const int *neighbours(int city) const {
+			return _neighbours.data() + (size_t) city * _numNeighbours;
+		}
+
+		//Member functions
+
+		//Applies improving 2-opt (or Lin-Kernighan) and Or-opt (segments of
+		//1-3 cities, either way round) moves to order until none is left;
+		//returns the new length given the old one
+		double improve(int *order, int numPoints, double length,
+		               LocalSearchScratch &scratch) const;
+};
+
+//Improves any tour, such as one from findAShortPath or an exact solver,
+//in place with Lin-Kernighan and Or-opt moves; returns its new length.
+//Builds the neighbour lists on each call, so keep a LocalSearch around
+//to improve many tours of one instance.
+double improveTour(std::vector<int> &tour, const DistanceMatrix &dist,
+                   int numNeighbours = 8, int numThreads = 1);
+
+#endif
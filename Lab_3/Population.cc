@@ -0,0 +1,98 @@
+#include "Population.hh"
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+
+using namespace std;
+
+//Constructors
+Population::Population(int size, int numPoints)
+		: _size(size), _numPoints(numPoints), _current(0) {
+
+	//Pad rows to 16 ints so every tour starts on a cache line
+	_stride = (numPoints + 15) & ~15;
+	size_t bytes = (size_t) size * _stride * sizeof(int);
+	_tours[0] = _tours[1] = 0;
+	for (int b = 0; b < 2; b++) {
+		void *mem = 0;
+		if (bytes && posix_memalign(&mem, 64, bytes) != 0) {
+			release();
+			throw bad_alloc();
+		}
+		_tours[b] = (int *) mem;
+		_fitness[b].assign(size, -1);
+	}
+	_ranked.resize(size);
+	for (int i = 0; i < size; i++) _ranked[i] = i;
+}
+
+Population::Population(Population &&other)
+		: _size(other._size), _numPoints(other._numPoints),
+		  _stride(other._stride), _current(other._current),
+		  _ranked(std::move(other._ranked)) {
+	for (int b = 0; b < 2; b++) {
+		_tours[b] = other._tours[b];
+		other._tours[b] = 0;
+		_fitness[b] = std::move(other._fitness[b]);
+	}
+}
+
+//Destructor
+Population::~Population() {
+	release();
+}
+
+Population &Population::operator=(Population &&other) {
+	if (this != &other) {
+		release();
+		_size = other._size;
+		_numPoints = other._numPoints;
+		_stride = other._stride;
+		_current = other._current;
+		_ranked = std::move(other._ranked);
+		for (int b = 0; b < 2; b++) {
+			_tours[b] = other._tours[b];
+			other._tours[b] = 0;
+			_fitness[b] = std::move(other._fitness[b]);
+		}
+	}
+	return *this;
+}
+
+void Population::release() {
+	for (int b = 0; b < 2; b++) {
+		free(_tours[b]);
+		_tours[b] = 0;
+	}
+}
+
+//Member functions
+void Population::rank() {
+	rank(_size);
+}
+
+void Population::rank(int count) {
+	const vector<double> &fit = _fitness[_current];
+	auto shorter = [&](int a, int b) {
+		return fit[a] < fit[b] || (fit[a] == fit[b] && a < b);
+	};
+	count = max(0, min(count, _size));
+	for (int i = 0; i < _size; i++) _ranked[i] = i;
+	if (count < _size) {
+		nth_element(_ranked.begin(), _ranked.begin() + count, _ranked.end(),
+		            shorter);
+	}
+	sort(_ranked.begin(), _ranked.begin() + count, shorter);
+}
+
+void Population::copyEliteToNext(int count) {
+	for (int r = 0; r < count; r++) {
+		memcpy(nextTour(r), tour(_ranked[r]), _numPoints * sizeof(int));
+		setNextFitness(r, fitness(_ranked[r]));
+	}
+}
+
+void Population::swapBuffers() {
+	_current = 1 - _current;
+}
@@ -0,0 +1,97 @@
+//Flat, double-buffered storage for a GA population
+#ifndef POPULATION_HH
+#define POPULATION_HH
+
+#include <vector>
+#include <cstddef>
+
+//All tours of one generation sit in a single 64-byte aligned buffer, one
+//row of numPoints cities per genome (rows padded to whole cache lines),
+//with fitness in a parallel array. Selection sorts a permutation of
+//genome indices instead of moving tours. The next generation is written
+//into a second buffer of the same shape and the two are swapped, so
+//carrying an elite genome over is one memcpy.
+class Population {
+	private:
+		int _size;
+		int _numPoints;
+		int _stride;                   //ints per row
+		int *_tours[2];
+		std::vector<double> _fitness[2];
+		int _current;                  //which buffer is this generation
+		std::vector<int> _ranked;      //genome indices, best first
+
+		void release();
+
+	public:
+		//Constructors
+		Population(int size, int numPoints);
+		Population(Population &&other);
+		Population(const Population &) = delete;
+
+		//Destructor
+		~Population();
+
+		Population &operator=(Population &&other);
+		Population &operator=(const Population &) = delete;
+
+		//Accessor methods
+		inline int size() const {
+			return _size;
+		}
+
+		inline int numPoints() const {
+			return _numPoints;
+		}
+
+		//Genome i of the current generation
+		inline int *tour(int i) {
+			return _tours[_current] + (size_t) i * _stride;
+		}
+
+		inline const int *tour(int i) const {
+			return _tours[_current] + (size_t) i * _stride;
+		}
+
+		inline double fitness(int i) const {
+			return _fitness[_current][i];
+		}
+
+		inline void setFitness(int i, double length) {
+			_fitness[_current][i] = length;
+		}
+
+		//Genome i of the generation being built
+		inline int *nextTour(int i) {
+			return _tours[1 - _current] + (size_t) i * _stride;
+		}
+
+		inline void setNextFitness(int i, double length) {
+			_fitness[1 - _current][i] = length;
+		}
+
+		//Index of the r-th shortest genome as of the last rank() call; after
+		//rank(count) only r < count is in order
+		inline int ranked(int r) const {
+			return _ranked[r];
+		}
+
+		//Member functions
+
+		//Orders genome indices by fitness; ties keep index order
+		void rank();
+
+		//Puts the count best genome indices, in order, at the front and the
+		//rest behind them in no particular order: an nth_element plus a sort
+		//of the prefix, O(size + count log count)
+		void rank(int count);
+
+		//Copies the count best genomes, in rank order, to the front of the
+		//next generation
+		void copyEliteToNext(int count);
+
+		//Makes the next generation current
+		void swapBuffers();
+};
+
+#endif
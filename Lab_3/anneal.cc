@@ -0,0 +1,282 @@
+#include "anneal.hh"
+#include "tsp-ga.hh"
+#include "parallel.hh"
+#include <iostream>
+#include <memory>
+#include <cmath>
+#include <algorithm>
+#include <cstdlib>
+
+using namespace std;
+
+//The temperature follows the schedule in steps of this many moves
+const int ANNEAL_STEP = 256;
+
+//Proposed moves sampled to pick the start temperature
+const int TEMPERATURE_SAMPLES = 1000;
+
+namespace {
+
+//One annealing chain: its tour with the position of every city, the
+//tour's length, its RNG, and the best tour seen at an epoch boundary
+struct Replica {
+	vector<int> order, pos;
+	double length;
+	Xoshiro256 rng;
+	vector<int> best;
+	double bestLength;
+};
+
+//A proposed move: swap positions i and j, or reverse [i, j]
+struct Move {
+	int i, j;
+	bool isSwap;
+	double delta;
+};
+
+//Reverses positions i..j (i <= j), or the rest of the cycle if that is
+//shorter; both give the same cycle
+void reverseSide(Replica &r, int n, int i, int j) {
+	int len = j - i + 1;
+	if (2 * len > n) {
+		int rest = n - len;
+		i = j + 1;
+		j = i + rest - 1;
+		len = rest;
+	}
+	for (int k = 0; k < len / 2; k++) {
+		int a = (i + k) % n, b = (j - k) % n;
+		swap(r.order[a], r.order[b]);
+		r.pos[r.order[a]] = a;
+		r.pos[r.order[b]] = b;
+	}
+}
+
+//Draws a move for replica r and scores it; false for a move that would
+//change nothing
+bool propose(Replica &r, int n, const DistanceMatrix &dist,
+             const LocalSearch *neighbours, double swapShare, Move &move) {
+	int i, j;
+	move.isSwap = r.rng.nextDouble() < swapShare;
+	if (!move.isSwap && neighbours) {
+
+		//City a at i and a near city c at j; reversing the stretch after a
+		//up to c (or from c up to just before a) makes them neighbours
+		i = r.rng.nextInt(0, n - 1);
+		int c = neighbours->neighbours(r.order[i])
+		        [r.rng.nextInt(0, neighbours->numNeighbours() - 1)];
+		j = r.pos[c];
+		if (i < j) {
+			i++;
+		} else {
+			swap(i, j);
+			j--;
+		}
+		if (i >= j) return false;
+	} else {
+		i = r.rng.nextInt(0, n - 1);
+		j = r.rng.nextInt(0, n - 2);
+		if (j >= i) j++;
+		if (i > j) swap(i, j);
+	}
+	move.i = i;
+	move.j = j;
+	move.delta = move.isSwap ? swapDelta(r.order.data(), n, i, j, dist)
+	                         : reverseDelta(r.order.data(), n, i, j, dist);
+	return true;
+}
+
+//Built with TSP_GA_CHECK_DELTAS, the new length is checked against a
+//full recomputation
+void apply(Replica &r, int n, const Move &move, const DistanceMatrix &dist) {
+	if (move.isSwap) {
+		swap(r.order[move.i], r.order[move.j]);
+		r.pos[r.order[move.i]] = move.i;
+		r.pos[r.order[move.j]] = move.j;
+	} else {
+		reverseSide(r, n, move.i, move.j);
+	}
+	r.length += move.delta;
+
+#ifdef TSP_GA_CHECK_DELTAS
+	double full = dist.tourLength(r.order.data(), n);
+	if (fabs(full - r.length) > 1e-9 * max(1.0, full)) {
+		cerr << "annealTour: incremental length " << r.length
+		     << " but full recomputation gives " << full << endl;
+		abort();
+	}
+#else
+	(void) dist;
+#endif
+}
+
+double temperatureAt(CoolingSchedule cooling, double t0, double t1,
+                     double progress) {
+	switch (cooling) {
+		case COOL_LINEAR: return t0 + (t1 - t0) * progress;
+		case COOL_RECIPROCAL: return t0 / (1 + (t0 / t1 - 1) * progress);
+		default: return t0 * pow(t1 / t0, progress);
+	}
+}
+
+}
+
+TSPGenome annealTour(const vector<Point> &points,
+                     const AnnealOptions &options) {
+
+	//A single city has only one tour, and nothing to move
+	if (points.size() < 2) {
+		TSPGenome only((int) points.size());
+		if (!points.empty()) only.computeCircuitLength(points);
+		return only;
+	}
+
+	//A seeded run draws the exchanges from stream 0 of its seed and
+	//replica r from stream r + 1
+	if (options.seeded) setThreadRng(rngStream(options.seed, 0));
+	const int n = (int) points.size();
+	const int numReplicas = max(1, options.numReplicas);
+	const int interval = max(1, options.exchangeInterval);
+
+	DistanceMatrix dist(points, options.numThreads);
+	unique_ptr<LocalSearch> neighbours;
+	if (options.numNeighbours > 0 && n > 3) {
+		neighbours.reset(new LocalSearch(dist, min(options.numNeighbours, n - 1),
+		                                 options.numThreads));
+	}
+	unique_ptr<TourBuilder> builder;
+	if (options.start != INIT_RANDOM) {
+		builder.reset(new TourBuilder(dist, options.numThreads));
+	}
+
+	//Starting tours: replica 0 gets the plain construction, the others
+	//randomized ones, each from its own engine
+	vector<Replica> replicas(numReplicas);
+	const Xoshiro256 callerRng = threadRng();
+	for (int r = 0; r < numReplicas; r++) {
+		Replica &rep = replicas[r];
+		rep.rng = options.seeded ? rngStream(options.seed, r + 1) : Xoshiro256();
+		rep.order.resize(n);
+		setThreadRng(rep.rng);
+		switch (builder ? options.start : INIT_RANDOM) {
+			case INIT_NEAREST_NEIGHBOUR: builder->nearestNeighbour(rep.order.data(), r > 0); break;
+			case INIT_GREEDY: builder->greedyEdge(rep.order.data(), r > 0); break;
+			case INIT_CURVE: builder->curve(rep.order.data(), r > 0); break;
+			default: randomOrder(rep.order.data(), n);
+		}
+		rep.rng = threadRng();
+		rep.pos.resize(n);
+		for (int i = 0; i < n; i++) rep.pos[rep.order[i]] = i;
+		rep.length = dist.tourLength(rep.order.data(), n);
+		rep.best = rep.order;
+		rep.bestLength = rep.length;
+	}
+	setThreadRng(callerRng);
+	if (n <= 3) {
+		TSPGenome only(replicas[0].order);
+		only.computeCircuitLength(dist);
+		return only;
+	}
+
+	//Start so that the average worsening move from the first tour is
+	//accepted half the time
+	double t0 = options.startTemperature, t1 = options.endTemperature;
+	if (t0 <= 0) {
+		Replica probe = replicas[0];
+		double worse = 0;
+		int numWorse = 0;
+		for (int s = 0; s < TEMPERATURE_SAMPLES; s++) {
+			Move move;
+			if (propose(probe, n, dist, neighbours.get(), options.swapShare, move) &&
+			    move.delta > 0) {
+				worse += move.delta;
+				numWorse++;
+			}
+		}
+		t0 = numWorse ? worse / numWorse / log(2.0) : replicas[0].length / n;
+	}
+	if (t1 <= 0) t1 = t0 / 1000;
+	vector<double> ladder(numReplicas, 1.0);
+	for (int r = 1; r < numReplicas; r++) {
+		ladder[r] = pow(options.ladderRatio, (double) r / (numReplicas - 1));
+	}
+
+	//Replicas run interval moves at a time in parallel; between rounds
+	//neighbouring replicas may trade tours
+	ThreadPool pool(min(options.numThreads, numReplicas));
+	const long long moves = options.moves;
+	long long done = 0;
+	int round = 0, reported = 0;
+	while (done < moves) {
+		const long long steps = min((long long) interval, moves - done);
+		pool.run(numReplicas, [&](int r, int) {
+			Replica &rep = replicas[r];
+			double temperature = 0;
+			for (long long k = 0; k < steps; k++) {
+				if (k % ANNEAL_STEP == 0) {
+					double progress = (double) (done + k) / moves;
+					temperature = ladder[r] * temperatureAt(options.cooling, t0, t1, progress);
+				}
+				Move move;
+				if (!propose(rep, n, dist, neighbours.get(), options.swapShare, move)) continue;
+				if (move.delta <= 0 ||
+				    rep.rng.nextDouble() < exp(-move.delta / temperature)) {
+					apply(rep, n, move, dist);
+				}
+			}
+			if (rep.length < rep.bestLength) {
+				rep.best = rep.order;
+				rep.bestLength = rep.length;
+			}
+		});
+		done += steps;
+
+		//Metropolis exchange between replicas r and r + 1, alternating
+		//even and odd pairs from round to round
+		if (numReplicas > 1) {
+			double base = temperatureAt(options.cooling, t0, t1, (double) done / moves);
+			for (int r = round % 2; r + 1 < numReplicas; r += 2) {
+				Replica &cold = replicas[r], &hot = replicas[r + 1];
+				double exponent = (1 / (base * ladder[r]) - 1 / (base * ladder[r + 1])) *
+				                  (cold.length - hot.length);
+				if (exponent >= 0 || threadRng().nextDouble() < exp(exponent)) {
+					cold.order.swap(hot.order);
+					cold.pos.swap(hot.pos);
+					swap(cold.length, hot.length);
+				}
+			}
+		}
+		round++;
+
+		if (options.showProgress && done * 10 / moves > reported) {
+			reported = (int) (done * 10 / moves);
+			double best = replicas[0].bestLength;
+			for (const Replica &rep : replicas) best = min(best, rep.bestLength);
+			cout << "Move " << done << ": Shortest path is " << best << endl;
+		}
+	}
+
+	int bestReplica = 0;
+	for (int r = 1; r < numReplicas; r++) {
+		if (replicas[r].bestLength < replicas[bestReplica].bestLength) bestReplica = r;
+	}
+	TSPGenome result(replicas[bestReplica].best);
+	result.computeCircuitLength(dist);
+	return result;
+}
+
+const char *coolingName(CoolingSchedule cooling) {
+	switch (cooling) {
+		case COOL_LINEAR: return "linear";
+		case COOL_RECIPROCAL: return "reciprocal";
+		default: return "geometric";
+	}
+}
+
+bool parseCooling(const string &name, CoolingSchedule &cooling) {
+	if (name == "geometric") cooling = COOL_GEOMETRIC;
+	else if (name == "linear") cooling = COOL_LINEAR;
+	else if (name == "reciprocal") cooling = COOL_RECIPROCAL;
+	else return false;
+	return true;
+}
@@ -0,0 +1,75 @@
+//Simulated annealing and parallel tempering on a single tour
+#ifndef ANNEAL_HH
+#define ANNEAL_HH
+
+#include <vector>
+#include <string>
+#include <cstdint>
+#include "Point.hh"
+#include "construct.hh"
+#include "parallel.hh"
+
+//annealTour returns a TSPGenome; include tsp-ga.hh to use it
+class TSPGenome;
+
+//Simulated annealing cooling schedules, as the temperature at progress
+//p in [0, 1] from start temperature T0 to end temperature T1:
+//  geometric  - T0 (T1/T0)^p, the same fraction lost at every step
+//  linear     - T0 + (T1 - T0) p
+//  reciprocal - T0 / (1 + (T0/T1 - 1) p), fast at first, then lingering
+//               near the cold end
+enum CoolingSchedule {
+	COOL_GEOMETRIC,
+	COOL_LINEAR,
+	COOL_RECIPROCAL
+};
+
+//Settings for annealTour
+struct AnnealOptions {
+	int numThreads;       //worker threads for the replicas
+	bool showProgress;    //print the best length ten times per run
+	bool seeded;          //if set, runs are reproducible from seed
+	uint64_t seed;
+	long long moves;      //move attempts per replica
+	CoolingSchedule cooling;
+
+	//Temperatures in units of length; 0 picks them from the instance:
+	//the start so that a typical worsening move is accepted half the
+	//time, the end a thousandth of that
+	double startTemperature;
+	double endTemperature;
+
+	//Moves: with numNeighbours > 0, 2-opt moves that make a random city
+	//adjacent to one of its numNeighbours nearest, except for a
+	//swapShare of random swaps; without, random 2-opt moves and swaps
+	int numNeighbours;
+	double swapShare;
+	InitStrategy start;   //starting tour of every replica
+
+	//Parallel tempering: numReplicas > 1 runs that many copies, replica
+	//r at the scheduled temperature times ladderRatio^(r/(numReplicas-1)),
+	//and every exchangeInterval moves offers neighbouring replicas a
+	//Metropolis swap of their tours
+	int numReplicas;
+	double ladderRatio;
+	int exchangeInterval;
+
+	AnnealOptions() : numThreads(defaultThreadCount()), showProgress(true),
+	                  seeded(false), seed(0), moves(1000000),
+	                  cooling(COOL_GEOMETRIC), startTemperature(0),
+	                  endTemperature(0), numNeighbours(8), swapShare(0.1),
+	                  start(INIT_RANDOM), numReplicas(1), ladderRatio(10),
+	                  exchangeInterval(1000) { }
+};
+
+//Simulated annealing (or, with replicas, parallel tempering) on a single
+//order per replica. Moves are scored with the O(1) swapDelta and
+//reverseDelta; a 2-opt move reverses whichever side of the cycle is
+//shorter. A seeded run gives the same tour on any number of threads.
+TSPGenome annealTour(const std::vector<Point> &points,
+                     const AnnealOptions &options);
+
+const char *coolingName(CoolingSchedule cooling);
+bool parseCooling(const std::string &name, CoolingSchedule &cooling);
+
+#endif
@@ -0,0 +1,249 @@
+#include "checkpoint.hh"
+#include <fstream>
+#include <iostream>
+#include <cstring>
+#include <cstdio>
+
+using namespace std;
+
+static const char CHECKPOINT_MAGIC[8] = { 'T', 'S', 'P', 'G', 'A', 'C', 'K', '1' };
+
+uint64_t hashPoints(const vector<Point> &points) {
+	uint64_t h = 14695981039346656037ULL;
+	for (const Point &p : points) {
+		double coords[3] = { p.getX(), p.getY(), p.getZ() };
+		unsigned char bytes[sizeof(coords)];
+		memcpy(bytes, coords, sizeof(coords));
+		for (unsigned char b : bytes) {
+			h ^= b;
+			h *= 1099511628211ULL;
+		}
+	}
+	return h;
+}
+
+void beginCheckpoint(Checkpoint &checkpoint, int generation, int numPoints,
+                     int populationSize, int keepPopulation,
+                     uint64_t pointsHash) {
+	checkpoint.generation = generation;
+	checkpoint.numPoints = numPoints;
+	checkpoint.populationSize = populationSize;
+	checkpoint.keepPopulation = keepPopulation;
+	checkpoint.numPopulations = 0;
+	checkpoint.pointsHash = pointsHash;
+	checkpoint.rngStates.clear();
+	checkpoint.tours.clear();
+	checkpoint.fitness.clear();
+}
+
+void saveEngine(Checkpoint &checkpoint, const Xoshiro256 &engine) {
+	uint64_t state[4];
+	engine.getState(state);
+	checkpoint.rngStates.insert(checkpoint.rngStates.end(), state, state + 4);
+}
+
+void savePopulation(Checkpoint &checkpoint, const Population &population) {
+	const int n = population.numPoints();
+	for (int i = 0; i < population.size(); i++) {
+		checkpoint.tours.insert(checkpoint.tours.end(), population.tour(i),
+		                        population.tour(i) + n);
+		checkpoint.fitness.push_back(population.fitness(i));
+	}
+	checkpoint.numPopulations++;
+}
+
+Xoshiro256 loadEngine(const Checkpoint &checkpoint, int index) {
+	Xoshiro256 engine(0);
+	engine.setState(checkpoint.rngStates.data() + 4 * (size_t) index);
+	return engine;
+}
+
+void loadPopulation(const Checkpoint &checkpoint, int index,
+                    Population &population) {
+	const int n = population.numPoints();
+	const size_t first = (size_t) index * population.size();
+	for (int i = 0; i < population.size(); i++) {
+		const int *tour = checkpoint.tours.data() + (first + i) * n;
+		copy(tour, tour + n, population.tour(i));
+		population.setFitness(i, checkpoint.fitness[first + i]);
+	}
+}
+
+//Raw reads and writes of one value or an array
+template <typename T>
+static void put(ostream &out, const T *values, size_t count) {
+	out.write((const char *) values, count * sizeof(T));
+}
+
+template <typename T>
+static bool get(istream &in, T *values, size_t count) {
+	return (bool) in.read((char *) values, count * sizeof(T));
+}
+
+bool writeCheckpoint(const string &path, const Checkpoint &checkpoint,
+                     string &error) {
+	string temporary = path + ".tmp";
+	{
+		ofstream out(temporary.c_str(), ios::out | ios::binary | ios::trunc);
+		if (!out) {
+			error = "cannot create " + temporary;
+			return false;
+		}
+		int32_t header[6] = { checkpoint.generation, checkpoint.numPoints,
+		                      checkpoint.populationSize, checkpoint.keepPopulation,
+		                      checkpoint.numPopulations,
+		                      (int32_t) (checkpoint.rngStates.size() / 4) };
+		put(out, CHECKPOINT_MAGIC, sizeof(CHECKPOINT_MAGIC));
+		put(out, header, 6);
+		put(out, &checkpoint.pointsHash, 1);
+		put(out, checkpoint.rngStates.data(), checkpoint.rngStates.size());
+		put(out, checkpoint.fitness.data(), checkpoint.fitness.size());
+		put(out, checkpoint.tours.data(), checkpoint.tours.size());
+		out.flush();
+		if (!out) {
+			error = "write to " + temporary + " failed";
+			return false;
+		}
+	}
+	if (rename(temporary.c_str(), path.c_str()) != 0) {
+		error = "cannot rename " + temporary + " to " + path;
+		return false;
+	}
+	return true;
+}
+
+bool readCheckpoint(const string &path, Checkpoint &checkpoint,
+                    string &error) {
+	ifstream in(path.c_str(), ios::in | ios::binary);
+	if (!in) {
+		error = "cannot open file";
+		return false;
+	}
+	char magic[sizeof(CHECKPOINT_MAGIC)];
+	int32_t header[6];
+	if (!get(in, magic, sizeof(magic)) ||
+	    memcmp(magic, CHECKPOINT_MAGIC, sizeof(magic)) != 0) {
+		error = "not a tsp-ga checkpoint";
+		return false;
+	}
+	if (!get(in, header, 6) || !get(in, &checkpoint.pointsHash, 1)) {
+		error = "truncated header";
+		return false;
+	}
+	for (int i = 0; i < 6; i++) {
+		if (header[i] < 0) {
+			error = "corrupt header";
+			return false;
+		}
+	}
+	checkpoint.generation = header[0];
+	checkpoint.numPoints = header[1];
+	checkpoint.populationSize = header[2];
+	checkpoint.keepPopulation = header[3];
+	checkpoint.numPopulations = header[4];
+
+	//Everything after the header has a size fixed by it; check that the
+	//file holds that much before allocating anything
+	streamoff start = in.tellg();
+	in.seekg(0, ios::end);
+	uint64_t remaining = (uint64_t) (in.tellg() - start);
+	in.seekg(start);
+	uint64_t genomes = (uint64_t) header[4] * (uint64_t) header[2];
+	uint64_t rngBytes = 4 * sizeof(uint64_t) * (uint64_t) header[5];
+	uint64_t fitnessBytes = sizeof(double) * genomes;
+	if (!in || rngBytes + fitnessBytes > remaining ||
+	    (header[1] > 0 &&
+	     genomes > (remaining - rngBytes - fitnessBytes) / sizeof(int32_t) / header[1])) {
+		error = "truncated file";
+		return false;
+	}
+	checkpoint.rngStates.resize(4 * (size_t) header[5]);
+	checkpoint.fitness.resize(genomes);
+	checkpoint.tours.resize(genomes * header[1]);
+	if (!get(in, checkpoint.rngStates.data(), checkpoint.rngStates.size()) ||
+	    !get(in, checkpoint.fitness.data(), checkpoint.fitness.size()) ||
+	    !get(in, checkpoint.tours.data(), checkpoint.tours.size())) {
+		error = "truncated file";
+		return false;
+	}
+
+	//Every saved tour must visit each city exactly once; seen[city] holds
+	//the last tour that visited it
+	const int n = checkpoint.numPoints;
+	vector<uint64_t> seen(n, genomes);
+	for (uint64_t g = 0; g < genomes; g++) {
+		const int *tour = checkpoint.tours.data() + g * n;
+		for (int i = 0; i < n; i++) {
+			int city = tour[i];
+			if (city < 0 || city >= n || seen[city] == g) {
+				error = "corrupt tour";
+				return false;
+			}
+			seen[city] = g;
+		}
+	}
+	return true;
+}
+
+bool checkpointMatches(const Checkpoint &checkpoint,
+                       const vector<Point> &points, int populationSize,
+                       int keepPopulation, int numIslands, int numEngines,
+                       string &error) {
+	if (checkpoint.numPoints != (int) points.size() ||
+	    checkpoint.pointsHash != hashPoints(points)) {
+		error = "checkpoint is for a different instance";
+	} else if (checkpoint.populationSize != populationSize ||
+	           checkpoint.keepPopulation != keepPopulation) {
+		error = "checkpoint population is " + to_string(checkpoint.populationSize)
+		      + " keeping " + to_string(checkpoint.keepPopulation);
+	} else if (checkpoint.numPopulations != numIslands) {
+		error = "checkpoint has " + to_string(checkpoint.numPopulations)
+		      + " island(s)";
+	} else if (checkpoint.rngStates.size() != 4 * (size_t) numEngines) {
+		error = "checkpoint has " + to_string(checkpoint.rngStates.size() / 4)
+		      + " RNG state(s), expected " + to_string(numEngines);
+	} else {
+		return true;
+	}
+	return false;
+}
+
+CheckpointWriter::CheckpointWriter(const string &path)
+		: _path(path), _hasPending(false), _stop(false),
+		  _thread(&CheckpointWriter::writerLoop, this) {
+}
+
+CheckpointWriter::~CheckpointWriter() {
+	{
+		lock_guard<mutex> lock(_mutex);
+		_stop = true;
+	}
+	_wake.notify_one();
+	_thread.join();
+}
+
+void CheckpointWriter::submit(Checkpoint &snapshot) {
+	{
+		lock_guard<mutex> lock(_mutex);
+		swap(_pending, snapshot);
+		_hasPending = true;
+	}
+	_wake.notify_one();
+}
+
+void CheckpointWriter::writerLoop() {
+	unique_lock<mutex> lock(_mutex);
+	for (;;) {
+		_wake.wait(lock, [&] { return _hasPending || _stop; });
+		if (!_hasPending) return;
+		swap(_writing, _pending);
+		_hasPending = false;
+		lock.unlock();
+
+		string error;
+		if (!writeCheckpoint(_path, _writing, error)) {
+			cerr << "checkpoint: " << error << endl;
+		}
+		lock.lock();
+	}
+}
@@ -0,0 +1,103 @@
+//Saving and restoring GA runs
+#ifndef CHECKPOINT_HH
+#define CHECKPOINT_HH
+
+#include <vector>
+#include <string>
+#include <cstdint>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include "Point.hh"
+#include "Population.hh"
+#include "rng.hh"
+
+//Everything needed to continue a findAShortPath run exactly where it
+//stopped: every population's current generation (tours and lengths)
+//and every RNG state, after `generation` completed generations. The
+//instance and the sizes that fix the RNG layout are recorded so a
+//checkpoint cannot be resumed against the wrong run.
+struct Checkpoint {
+	int generation;
+	int numPoints;
+	int populationSize;
+	int keepPopulation;
+	int numPopulations;            //one per island
+	uint64_t pointsHash;
+	std::vector<uint64_t> rngStates;   //4 words per engine
+	std::vector<int> tours;            //population after population, genome after genome
+	std::vector<double> fitness;
+
+	Checkpoint() : generation(0), numPoints(0), populationSize(0),
+	               keepPopulation(0), numPopulations(0), pointsHash(0) { }
+};
+
+//FNV-1a over the coordinates, identifying the instance
+uint64_t hashPoints(const std::vector<Point> &points);
+
+//Starts a snapshot: records the sizes and clears the buffers, keeping
+//their capacity
+void beginCheckpoint(Checkpoint &checkpoint, int generation, int numPoints,
+                     int populationSize, int keepPopulation,
+                     uint64_t pointsHash);
+
+//Appends to, or reads back from, a snapshot. Populations and engines
+//come back in the order they were saved; index counts from zero and is
+//not range checked, so a loaded checkpoint must pass checkpointMatches.
+void saveEngine(Checkpoint &checkpoint, const Xoshiro256 &engine);
+void savePopulation(Checkpoint &checkpoint, const Population &population);
+Xoshiro256 loadEngine(const Checkpoint &checkpoint, int index);
+void loadPopulation(const Checkpoint &checkpoint, int index,
+                    Population &population);
+
+//Binary file format: the magic "TSPGACK1", the header fields as 32- and
+//64-bit integers, the RNG words, every length, then every tour as 32-bit
+//city indices, all in host byte order. Writing goes through a temporary
+//file renamed into place, so a crash mid-write leaves the previous
+//checkpoint intact. Both return false and set error on failure.
+bool writeCheckpoint(const std::string &path, const Checkpoint &checkpoint,
+                     std::string &error);
+bool readCheckpoint(const std::string &path, Checkpoint &checkpoint,
+                    std::string &error);
+
+//Whether checkpoint belongs to this instance and these GA sizes, and
+//holds exactly numEngines RNG states (see checkpointEngineCount)
+bool checkpointMatches(const Checkpoint &checkpoint,
+                       const std::vector<Point> &points, int populationSize,
+                       int keepPopulation, int numIslands, int numEngines,
+                       std::string &error);
+
+//Writes checkpoints on a background thread so the GA only pays for the
+//in-memory snapshot. If a new snapshot arrives while one is still being
+//written, only the newest is kept. The destructor finishes the pending
+//write; errors are reported on cerr and do not stop the run.
+class CheckpointWriter {
+	private:
+		std::string _path;
+		Checkpoint _pending;
+		Checkpoint _writing;
+		bool _hasPending;
+		bool _stop;
+		std::mutex _mutex;
+		std::condition_variable _wake;
+		std::thread _thread;
+
+		void writerLoop();
+
+	public:
+		//Constructor
+		explicit CheckpointWriter(const std::string &path);
+		CheckpointWriter(const CheckpointWriter &) = delete;
+		CheckpointWriter &operator=(const CheckpointWriter &) = delete;
+
+		//Destructor
+		~CheckpointWriter();
+
+		//Member functions
+
+		//Queues snapshot for writing. snapshot is swapped with the queue
+		//slot, so it comes back holding older buffers to refill.
+		void submit(Checkpoint &snapshot);
+};
+
+#endif
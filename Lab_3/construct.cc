@@ -0,0 +1,269 @@
+#include "construct.hh"
+#include "curve.hh"
+#include "parallel.hh"
+#include "rng.hh"
+#include <algorithm>
+#include <cstdlib>
+
+using namespace std;
+
+//Chance that a randomized nearest neighbour tour takes the second
+//nearest city, and the largest relative noise on greedy edge lengths
+const double NN_SECOND_CHOICE = 0.1;
+const double GREEDY_NOISE = 0.25;
+
+//A scan of the cities left beats a kd-tree query for k of them once
+//there are fewer than this many times k
+const int SCAN_RATIO = 16;
+
+static const char *const INIT_NAMES[NUM_INIT_STRATEGIES] = {
+	"random", "nn", "greedy", "curve"
+};
+
+bool InitMix::allRandom() const {
+	for (int s = 0; s < NUM_INIT_STRATEGIES; s++) {
+		if (s != INIT_RANDOM && weight[s] > 0) return false;
+	}
+	return true;
+}
+
+void InitMix::counts(int size, int result[NUM_INIT_STRATEGIES]) const {
+	double total = 0;
+	for (int s = 0; s < NUM_INIT_STRATEGIES; s++) total += weight[s];
+	int assigned = 0;
+	for (int s = 0; s < NUM_INIT_STRATEGIES; s++) {
+		result[s] = total > 0 ? (int) (size * weight[s] / total) : 0;
+		assigned += result[s];
+	}
+	result[INIT_RANDOM] += size - assigned;
+}
+
+bool TourBuilder::Edge::operator<(const Edge &other) const {
+	if (length != other.length) return length < other.length;
+	if (a != other.a) return a < other.a;
+	return b < other.b;
+}
+
+bool parseInitMix(const string &spec, InitMix &mix) {
+	InitMix parsed;
+	parsed.weight[INIT_RANDOM] = 0;
+	size_t start = 0;
+	while (start <= spec.size()) {
+		size_t end = spec.find(',', start);
+		if (end == string::npos) end = spec.size();
+		string item = spec.substr(start, end - start);
+		size_t colon = item.find(':');
+		string name = item.substr(0, colon);
+		double weight = 1;
+		if (colon != string::npos) {
+			const char *text = item.c_str() + colon + 1;
+			char *rest;
+			weight = strtod(text, &rest);
+			if (rest == text || *rest != '\0' || weight < 0) return false;
+		}
+		InitStrategy s;
+		if (!parseInitStrategy(name, s)) return false;
+		parsed.weight[s] += weight;
+		start = end + 1;
+	}
+	double total = 0;
+	for (int s = 0; s < NUM_INIT_STRATEGIES; s++) total += parsed.weight[s];
+	if (total <= 0) return false;
+	mix = parsed;
+	return true;
+}
+
+const char *initStrategyName(InitStrategy strategy) {
+	return INIT_NAMES[strategy];
+}
+
+bool parseInitStrategy(const string &name, InitStrategy &strategy) {
+	for (int s = 0; s < NUM_INIT_STRATEGIES; s++) {
+		if (name == INIT_NAMES[s]) {
+			strategy = (InitStrategy) s;
+			return true;
+		}
+	}
+	return false;
+}
+
+TourBuilder::TourBuilder(const DistanceMatrix &dist, int numThreads)
+		: _dist(dist), _tree(dist.cloud(), numThreads),
+		  _numCandidates(min(GREEDY_CANDIDATES, max(0, dist.size() - 1))),
+		  _candidates((size_t) dist.size() * _numCandidates) {
+	if (_numCandidates == 0) return;
+	vector<vector<int> > found(max(1, numThreads));
+	parallelFor(dist.size(), numThreads, [&](int i, int thread) {
+		_tree.nearest(i, _numCandidates, found[thread]);
+		copy(found[thread].begin(), found[thread].end(),
+		     _candidates.begin() + (size_t) i * _numCandidates);
+	});
+
+	for (int a = 0; a < dist.size(); a++) {
+		const int *candidates = &_candidates[(size_t) a * _numCandidates];
+		for (int c = 0; c < _numCandidates; c++) {
+			Edge e;
+			e.a = min(a, candidates[c]);
+			e.b = max(a, candidates[c]);
+			e.length = dist(e.a, e.b);
+			_edges.push_back(e);
+		}
+	}
+	sort(_edges.begin(), _edges.end());
+	_edges.erase(unique(_edges.begin(), _edges.end(),
+	                    [](const Edge &x, const Edge &y) {
+	                      return x.a == y.a && x.b == y.b;
+	                    }),
+	             _edges.end());
+}
+
+void TourBuilder::CitySet::insert(int city) {
+	position[city] = (int) members.size();
+	members.push_back(city);
+}
+
+void TourBuilder::CitySet::remove(int city) {
+	int last = members.back();
+	members[position[city]] = last;
+	position[last] = position[city];
+	members.pop_back();
+	position[city] = -1;
+}
+
+void TourBuilder::nearestAllowed(int city, const CitySet &allowed, int count,
+                                 vector<int> &result,
+                                 vector<int> &buffer) const {
+	result.clear();
+	const int *candidates = &_candidates[(size_t) city * _numCandidates];
+	for (int c = 0; c < _numCandidates && (int) result.size() < count; c++) {
+		if (allowed.contains(candidates[c])) result.push_back(candidates[c]);
+	}
+	if ((int) result.size() == count) return;
+
+	//Everything close is taken; widen the search until enough turn up
+	const int others = _dist.size() - 1;
+	for (int k = 2 * _numCandidates; ; k *= 2) {
+		result.clear();
+		if (SCAN_RATIO * k >= (int) allowed.members.size() || k >= others) break;
+		_tree.nearest(city, k, buffer);
+		for (int c : buffer) {
+			if (allowed.contains(c)) result.push_back(c);
+			if ((int) result.size() == count) return;
+		}
+	}
+
+	//Few enough left to compare them all: keep the count nearest, in order
+	for (int c : allowed.members) {
+		if (c == city) continue;
+		double d = _dist(city, c);
+		int at = (int) result.size();
+		while (at > 0 && d < _dist(city, result[at - 1])) at--;
+		if (at < count) {
+			result.insert(result.begin() + at, c);
+			if ((int) result.size() > count) result.pop_back();
+		}
+	}
+}
+
+void TourBuilder::nearestNeighbour(int *order, bool randomized) const {
+	const int n = _dist.size();
+	if (n == 0) return;
+	Xoshiro256 &rng = threadRng();
+	CitySet unvisited(n);
+	for (int c = 0; c < n; c++) unvisited.insert(c);
+	vector<int> found, buffer;
+
+	int city = randomized ? rng.nextInt(0, n - 1) : 0;
+	order[0] = city;
+	unvisited.remove(city);
+	for (int pos = 1; pos < n; pos++) {
+		nearestAllowed(city, unvisited, randomized ? 2 : 1, found, buffer);
+		city = found[0];
+		if (found.size() > 1 && rng.nextDouble() < NN_SECOND_CHOICE) {
+			city = found[1];
+		}
+		order[pos] = city;
+		unvisited.remove(city);
+	}
+}
+
+namespace {
+
+//Root of city's fragment, halving paths on the way
+inline int findRoot(vector<int> &parent, int city) {
+	while (parent[city] != city) {
+		parent[city] = parent[parent[city]];
+		city = parent[city];
+	}
+	return city;
+}
+
+}
+
+void TourBuilder::greedyEdge(int *order, bool randomized) const {
+	const int n = _dist.size();
+	if (n == 0) return;
+	Xoshiro256 &rng = threadRng();
+
+	//Randomized tours take the edges in a noisy order
+	vector<Edge> noisy;
+	if (randomized) {
+		noisy = _edges;
+		for (Edge &e : noisy) e.length *= 1 + GREEDY_NOISE * rng.nextDouble();
+		sort(noisy.begin(), noisy.end());
+	}
+	const vector<Edge> &edges = randomized ? noisy : _edges;
+
+	//Take every edge that leaves both ends at degree two or less and
+	//joins two different paths
+	vector<int> degree(n, 0), adjacent(2 * (size_t) n, -1), parent(n);
+	for (int c = 0; c < n; c++) parent[c] = c;
+	for (const Edge &e : edges) {
+		if (degree[e.a] == 2 || degree[e.b] == 2) continue;
+		int ra = findRoot(parent, e.a), rb = findRoot(parent, e.b);
+		if (ra == rb) continue;
+		parent[ra] = rb;
+		adjacent[2 * e.a + degree[e.a]++] = e.b;
+		adjacent[2 * e.b + degree[e.b]++] = e.a;
+	}
+
+	//Walk the paths, each time hopping to the nearest free endpoint of
+	//another path; start at an end of a path (of a random city's path)
+	CitySet freeEnd(n);
+	for (int c = 0; c < n; c++) {
+		if (degree[c] < 2) freeEnd.insert(c);
+	}
+	vector<int> found, buffer;
+	int city = randomized ? rng.nextInt(0, n - 1) : 0;
+	for (int prev = -1; degree[city] == 2; ) {
+		int next = adjacent[2 * city] != prev ? adjacent[2 * city]
+		                                       : adjacent[2 * city + 1];
+		prev = city;
+		city = next;
+	}
+	int pos = 0;
+	while (true) {
+		for (int prev = -1; city != -1; ) {
+			order[pos++] = city;
+			if (freeEnd.contains(city)) freeEnd.remove(city);
+			int next = adjacent[2 * city] != prev ? adjacent[2 * city]
+			                                       : adjacent[2 * city + 1];
+			prev = city;
+			city = next;
+		}
+		if (pos == n) break;
+		nearestAllowed(order[pos - 1], freeEnd, 1, found, buffer);
+		city = found[0];
+	}
+}
+
+void TourBuilder::curve(int *order, bool randomized) const {
+	if (!randomized) {
+		curveOrder(_dist.cloud(), order);
+		return;
+	}
+	Xoshiro256 &rng = threadRng();
+	double shift[3];
+	for (int a = 0; a < 3; a++) shift[a] = rng.nextDouble();
+	curveOrder(_dist.cloud(), order, shift);
+}
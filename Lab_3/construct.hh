@@ -0,0 +1,110 @@
+//Construction heuristics for starting tours
+#ifndef CONSTRUCT_HH
+#define CONSTRUCT_HH
+
+#include <vector>
+#include <string>
+#include "DistanceMatrix.hh"
+#include "KdTree.hh"
+
+//Candidate edges per city considered by greedy edge
+const int GREEDY_CANDIDATES = 10;
+
+//How a genome of the first generation is built:
+//  random  - a uniform shuffle (the original initialisation)
+//  nn      - nearest neighbour from a start city
+//  greedy  - greedy edge: the shortest candidate edges that keep every
+//            city at degree two or less without closing a cycle, the
+//            resulting paths then joined nearest endpoint first
+//  curve   - the order of the points along a 3D Hilbert curve
+enum InitStrategy {
+	INIT_RANDOM,
+	INIT_NEAREST_NEIGHBOUR,
+	INIT_GREEDY,
+	INIT_CURVE,
+	NUM_INIT_STRATEGIES
+};
+
+//Relative weights of the strategies in the first generation; the
+//default is all random
+struct InitMix {
+	double weight[NUM_INIT_STRATEGIES];
+
+	InitMix() : weight() {
+		weight[INIT_RANDOM] = 1;
+	}
+
+	//True if every genome would be a random shuffle
+	bool allRandom() const;
+
+	//Genomes of each strategy in a population of size, in proportion to
+	//the weights; rounding leftovers go to random
+	void counts(int size, int result[NUM_INIT_STRATEGIES]) const;
+};
+
+//Parses "name:weight,name:weight,..." with the names above, e.g.
+//"nn:0.2,greedy:0.2,random:0.6"; a name without a weight counts 1.
+//Returns false, leaving mix alone, on a malformed spec.
+bool parseInitMix(const std::string &spec, InitMix &mix);
+
+//Name of a strategy as above, and its inverse; parseInitStrategy returns
+//false for an unknown name
+const char *initStrategyName(InitStrategy strategy);
+bool parseInitStrategy(const std::string &name, InitStrategy &strategy);
+
+//Builds starting tours from a kd-tree over the points. The first tour of
+//a strategy is its plain form; randomized tours start from a random
+//city (nn), sometimes take the second nearest city (nn), perturb edge
+//lengths by up to a quarter (greedy) or shift the curve's grid (curve),
+//drawing from the calling thread's RNG. Const and safe to share between
+//threads.
+class TourBuilder {
+	private:
+		const DistanceMatrix &_dist;
+		KdTree _tree;
+		int _numCandidates;
+		std::vector<int> _candidates;    //nearest others of each city
+
+		//Candidate edges, each once as (low, high), shortest first
+		struct Edge {
+			double length;
+			int a, b;
+
+			bool operator<(const Edge &other) const;
+		};
+		std::vector<Edge> _edges;
+
+		//Cities still to be picked, removable in O(1)
+		struct CitySet {
+			std::vector<int> members, position;   //position -1: not a member
+
+			CitySet(int n) : position(n, -1) { }
+
+			inline bool contains(int city) const {
+				return position[city] >= 0;
+			}
+
+			void insert(int city);
+			void remove(int city);
+		};
+
+		//Up to count members of allowed, nearest to city first: from the
+		//candidate list if it has enough, else kd-tree queries of growing
+		//k, or a scan of allowed once that is the cheaper job
+		void nearestAllowed(int city, const CitySet &allowed, int count,
+		                    std::vector<int> &result,
+		                    std::vector<int> &buffer) const;
+
+	public:
+		//Constructors
+		TourBuilder(const DistanceMatrix &dist, int numThreads = 1);
+
+		//Member functions
+
+		//Each writes a tour of all dist.size() cities to order
+		void nearestNeighbour(int *order, bool randomized) const;
+		void greedyEdge(int *order, bool randomized) const;
+		void curve(int *order, bool randomized) const;
+};
+
+#endif
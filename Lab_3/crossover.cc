@@ -0,0 +1,359 @@
+#include "crossover.hh"
+#include "rng.hh"
+#include <algorithm>
+
+using namespace std;
+
+unsigned int CrossoverScratch::nextMark(int n) {
+	if ((int) stamp.size() < n) {
+		stamp.assign(n, 0);
+		mark = 0;
+	}
+	if (++mark == 0) {
+		fill(stamp.begin(), stamp.end(), 0);
+		mark = 1;
+	}
+	return mark;
+}
+
+void crossoverOrders(CrossoverKind kind, const int *g1Order,
+                     const int *g2Order, int *orderOffspring, int numPoints,
+                     const DistanceMatrix &dist, const LocalSearch *neighbours,
+                     CrossoverScratch &scratch) {
+	switch (kind) {
+		case CROSSOVER_OX:
+			orderCrossover(g1Order, g2Order, orderOffspring, numPoints, scratch);
+			break;
+		case CROSSOVER_PMX:
+			partiallyMappedCrossover(g1Order, g2Order, orderOffspring, numPoints,
+			                         scratch);
+			break;
+		case CROSSOVER_EAX:
+			edgeAssemblyCrossover(g1Order, g2Order, orderOffspring, numPoints, dist,
+			                      neighbours, scratch);
+			break;
+		default:
+			crosslinkOrders(g1Order, g2Order, orderOffspring, numPoints, scratch);
+	}
+}
+
+void crosslinkOrders(const int *g1Order, const int *g2Order,
+                     int *orderOffspring, int genomeLength,
+                     CrossoverScratch &scratch) {
+
+	const unsigned int mark = scratch.nextMark(genomeLength);
+	unsigned int *placed = scratch.stamp.data();
+
+	int cut = threadRng().nextInt(0, genomeLength - 1);
+
+	//Prefix of g1, then the remaining cities in g2's order
+	int filled = 0;
+	for (int i = 0; i < cut; i++)	{
+		orderOffspring[filled++] = g1Order[i];
+		placed[g1Order[i]] = mark;
+	}
+
+	for (int i = 0; i < genomeLength && filled < genomeLength; i++) {
+		if (placed[g2Order[i]] != mark) {
+			orderOffspring[filled++] = g2Order[i];
+			placed[g2Order[i]] = mark;
+		}
+	}
+}
+
+//Random slice [first, last] of an order of n cities
+static void randomSlice(int n, int &first, int &last) {
+	Xoshiro256 &g = threadRng();
+	first = g.nextInt(0, n - 1);
+	last = g.nextInt(0, n - 1);
+	if (first > last) swap(first, last);
+}
+
+void orderCrossover(const int *g1Order, const int *g2Order,
+                    int *orderOffspring, int numPoints,
+                    CrossoverScratch &scratch) {
+
+	const int n = numPoints;
+	const unsigned int mark = scratch.nextMark(n);
+	unsigned int *placed = scratch.stamp.data();
+	int first, last;
+	randomSlice(n, first, last);
+
+	for (int i = first; i <= last; i++) {
+		orderOffspring[i] = g1Order[i];
+		placed[g1Order[i]] = mark;
+	}
+
+	//Fill from just after the slice, wrapping, in g2's order starting at
+	//the same place
+	int to = last + 1 == n ? 0 : last + 1;
+	for (int k = 1; k <= n; k++) {
+		int city = g2Order[(last + k) % n];
+		if (placed[city] == mark) continue;
+		orderOffspring[to] = city;
+		to = to + 1 == n ? 0 : to + 1;
+	}
+}
+
+void partiallyMappedCrossover(const int *g1Order, const int *g2Order,
+                              int *orderOffspring, int numPoints,
+                              CrossoverScratch &scratch) {
+
+	const int n = numPoints;
+	const unsigned int mark = scratch.nextMark(n);
+	unsigned int *inSlice = scratch.stamp.data();
+	if ((int) scratch.position.size() < n) scratch.position.resize(n);
+	int *position = scratch.position.data();
+	int first, last;
+	randomSlice(n, first, last);
+
+	for (int i = first; i <= last; i++) {
+		orderOffspring[i] = g1Order[i];
+		inSlice[g1Order[i]] = mark;
+		position[g1Order[i]] = i;
+	}
+
+	//Outside the slice take g2's city; if the slice already has it,
+	//follow g1[p] -> g2[p] until reaching a city the slice lacks
+	for (int i = 0; i < n; i++) {
+		if (i == first) {
+			i = last;
+			continue;
+		}
+		int city = g2Order[i];
+		while (inSlice[city] == mark) city = g2Order[position[city]];
+		orderOffspring[i] = city;
+	}
+}
+
+//Adjacency helpers for eax: every city has two slots, -1 when empty
+static inline void addEdge(int *adj, int u, int v) {
+	adj[2 * u + (adj[2 * u] < 0 ? 0 : 1)] = v;
+	adj[2 * v + (adj[2 * v] < 0 ? 0 : 1)] = u;
+}
+
+static inline void removeEdge(int *adj, int u, int v) {
+	adj[2 * u + (adj[2 * u] == v ? 0 : 1)] = -1;
+	adj[2 * v + (adj[2 * v] == u ? 0 : 1)] = -1;
+}
+
+static inline bool hasEdge(const int *adj, int u, int v) {
+	return adj[2 * u] == v || adj[2 * u + 1] == v;
+}
+
+//The neighbour of city in the tour adj that is not from, stepping along
+//a cycle
+static inline int nextOnCycle(const int *adj, int city, int from) {
+	return adj[2 * city] == from ? adj[2 * city + 1] : adj[2 * city];
+}
+
+void edgeAssemblyCrossover(const int *g1Order, const int *g2Order,
+                           int *orderOffspring, int numPoints,
+                           const DistanceMatrix &dist,
+                           const LocalSearch *neighbours,
+                           CrossoverScratch &scratch) {
+
+	const int n = numPoints;
+	if (n < 4) {
+		copy(g1Order, g1Order + n, orderOffspring);
+		return;
+	}
+	CrossoverScratch &s = scratch;
+	if ((int) s.child.size() < 2 * n) {
+		s.onlyA.resize(2 * n);
+		s.onlyB.resize(2 * n);
+		s.child.resize(2 * n);
+		s.path.resize(2 * n + 1);
+		s.pathPos.resize(2 * n);
+		s.subtour.resize(n);
+		s.subtourSize.resize(n);
+		s.members.resize(n);
+	}
+	int *onlyA = s.onlyA.data(), *onlyB = s.onlyB.data(), *child = s.child.data();
+
+	//The child starts as parent A. onlyA and onlyB end up holding the
+	//edges the parents do not share (onlyB briefly holds all of B).
+	fill(child, child + 2 * n, -1);
+	fill(onlyA, onlyA + 2 * n, -1);
+	fill(onlyB, onlyB + 2 * n, -1);
+	for (int i = 0; i < n; i++) {
+		addEdge(child, g1Order[i], g1Order[(i + 1) % n]);
+		addEdge(onlyB, g2Order[i], g2Order[(i + 1) % n]);
+	}
+	int numDiffering = 0;
+	for (int i = 0; i < n; i++) {
+		int u = g1Order[i], v = g1Order[(i + 1) % n];
+		if (!hasEdge(onlyB, u, v)) {
+			addEdge(onlyA, u, v);
+			numDiffering++;
+		}
+	}
+	if (numDiffering == 0) {
+		copy(g1Order, g1Order + n, orderOffspring);
+		return;
+	}
+	fill(onlyB, onlyB + 2 * n, -1);
+	for (int i = 0; i < n; i++) {
+		int u = g2Order[i], v = g2Order[(i + 1) % n];
+		if (!hasEdge(child, u, v)) addEdge(onlyB, u, v);
+	}
+
+	//Trace one AB-cycle: from a random city on a differing edge, walk
+	//along A-only and B-only edges in turn, using each up once, until the
+	//walk comes back to a city at the same parity. Every city has as many
+	//A-only as B-only edges, so the walk cannot get stuck.
+	Xoshiro256 &g = threadRng();
+	int start = g.nextInt(0, n - 1);
+	while (onlyA[2 * start] < 0 && onlyA[2 * start + 1] < 0) {
+		start = start + 1 == n ? 0 : start + 1;
+	}
+	const unsigned int mark = s.nextMark(2 * n);
+	unsigned int *seen = s.stamp.data();   //one slot per (parity, city)
+	int *path = s.path.data(), *pathPos = s.pathPos.data();
+	int steps = 0, cycleStart = 0;
+	path[0] = start;
+	seen[start] = mark;
+	pathPos[start] = 0;
+	for (;;) {
+		int u = path[steps];
+		int *edges = steps % 2 == 0 ? onlyA : onlyB;
+		int a = edges[2 * u], b = edges[2 * u + 1];
+		int v = a < 0 ? b : b < 0 ? a : (g() & 1 ? b : a);
+		removeEdge(edges, u, v);
+		path[++steps] = v;
+		int slot = (steps % 2) * n + v;
+		if (seen[slot] == mark) {
+			cycleStart = pathPos[slot];
+			break;
+		}
+		seen[slot] = mark;
+		pathPos[slot] = steps;
+	}
+
+	//Swap the cycle's A edges (odd steps) for its B edges (even steps).
+	//The child then has degree two everywhere but may fall into subtours.
+	for (int k = cycleStart + 1; k <= steps; k++) {
+		if (k % 2 == 1) removeEdge(child, path[k - 1], path[k]);
+	}
+	for (int k = cycleStart + 1; k <= steps; k++) {
+		if (k % 2 == 0) addEdge(child, path[k - 1], path[k]);
+	}
+
+	int *subtour = s.subtour.data(), *subtourSize = s.subtourSize.data();
+	int *members = s.members.data();
+	fill(subtour, subtour + n, -1);
+	int numSubtours = 0;
+	for (int v = 0; v < n; v++) {
+		if (subtour[v] >= 0) continue;
+		int id = numSubtours++, count = 0;
+		int prev = child[2 * v + 1], cur = v;
+		do {
+			subtour[cur] = id;
+			count++;
+			int next = nextOnCycle(child, cur, prev);
+			prev = cur;
+			cur = next;
+		} while (cur != v);
+		subtourSize[id] = count;
+	}
+
+	//Join the smallest subtour to another by replacing one edge (u, v) of
+	//it and one edge (w, z) outside it with the cheapest reconnection
+	while (numSubtours > 1) {
+		int smallest = -1, first = -1;
+		for (int v = 0; v < n; v++) {
+			if (smallest < 0 || subtourSize[subtour[v]] < subtourSize[smallest]) {
+				smallest = subtour[v];
+				first = v;
+			}
+		}
+		int m = 0, prev = child[2 * first + 1], cur = first;
+		do {
+			members[m++] = cur;
+			int next = nextOnCycle(child, cur, prev);
+			prev = cur;
+			cur = next;
+		} while (cur != first);
+
+		//Candidates w are the near neighbours of u when lists are given;
+		//if none of those lies outside the subtour, every city is tried
+		double best = 0;
+		int bu = -1, bv = -1, bw = -1, bz = -1;
+		bool crossed = false;
+		auto consider = [&](int u, int v, double duv, int w) {
+			for (int side = 0; side < 2; side++) {
+				int z = child[2 * w + side];
+				double base = duv + dist(w, z);
+				double straight = dist(u, w) + dist(v, z) - base;
+				double across = dist(u, z) + dist(v, w) - base;
+				if (bu < 0 || straight < best) {
+					best = straight;
+					bu = u; bv = v; bw = w; bz = z;
+					crossed = false;
+				}
+				if (across < best) {
+					best = across;
+					bu = u; bv = v; bw = w; bz = z;
+					crossed = true;
+				}
+			}
+		};
+		const int k = neighbours ? neighbours->numNeighbours() : 0;
+		for (int i = 0; i < m; i++) {
+			int u = members[i], v = members[i + 1 == m ? 0 : i + 1];
+			double duv = dist(u, v);
+			const int *near = k ? neighbours->neighbours(u) : 0;
+			for (int j = 0; j < k; j++) {
+				if (subtour[near[j]] != smallest) consider(u, v, duv, near[j]);
+			}
+		}
+		for (int i = 0; i < m && bu < 0; i++) {
+			int u = members[i], v = members[i + 1 == m ? 0 : i + 1];
+			double duv = dist(u, v);
+			for (int w = 0; w < n; w++) {
+				if (subtour[w] != smallest) consider(u, v, duv, w);
+			}
+		}
+
+		removeEdge(child, bu, bv);
+		removeEdge(child, bw, bz);
+		if (crossed) {
+			addEdge(child, bu, bz);
+			addEdge(child, bv, bw);
+		} else {
+			addEdge(child, bu, bw);
+			addEdge(child, bv, bz);
+		}
+		int target = subtour[bw];
+		for (int i = 0; i < m; i++) subtour[members[i]] = target;
+		subtourSize[target] += m;
+		numSubtours--;
+	}
+
+	//Read the single remaining cycle off, starting where parent A does
+	int prev = child[2 * g1Order[0] + 1], cur = g1Order[0];
+	for (int i = 0; i < n; i++) {
+		orderOffspring[i] = cur;
+		int next = nextOnCycle(child, cur, prev);
+		prev = cur;
+		cur = next;
+	}
+}
+
+const char *crossoverName(CrossoverKind kind) {
+	switch (kind) {
+		case CROSSOVER_OX: return "ox";
+		case CROSSOVER_PMX: return "pmx";
+		case CROSSOVER_EAX: return "eax";
+		default: return "prefix";
+	}
+}
+
+bool parseCrossover(const string &name, CrossoverKind &kind) {
+	if (name == "prefix") kind = CROSSOVER_PREFIX;
+	else if (name == "ox") kind = CROSSOVER_OX;
+	else if (name == "pmx") kind = CROSSOVER_PMX;
+	else if (name == "eax") kind = CROSSOVER_EAX;
+	else return false;
+	return true;
+}
@@ -0,0 +1,83 @@
+//Crossover operators on raw tour orders
+#ifndef CROSSOVER_HH
+#define CROSSOVER_HH
+
+#include <vector>
+#include <string>
+#include "DistanceMatrix.hh"
+#include "LocalSearch.hh"
+
+//Which operator breeds offspring:
+//  prefix - a random-length prefix of the first parent, then the other
+//           cities in the second parent's order (the original crosslink)
+//  ox     - order crossover: a random slice of the first parent stays in
+//           place, the rest follow the second parent's order after it
+//  pmx    - partially mapped crossover: a slice of the first parent, the
+//           rest from the second parent in place, clashes resolved
+//           through the slice's position mapping
+//  eax    - edge assembly crossover: the first parent with one AB-cycle
+//           of edges swapped for the second parent's, subtours then
+//           greedily merged by the cheapest 2-opt style reconnection
+enum CrossoverKind {
+	CROSSOVER_PREFIX,
+	CROSSOVER_OX,
+	CROSSOVER_PMX,
+	CROSSOVER_EAX
+};
+
+//Reusable working memory for the crossover operators. A city counts as
+//marked when its stamp equals the current mark, so resetting is one
+//increment instead of clearing an n-element set. The other arrays are
+//sized on first use and reused; nothing is allocated after that.
+struct CrossoverScratch {
+	std::vector<unsigned int> stamp;
+	unsigned int mark;
+
+	std::vector<int> position;      //pmx: slice positions in the first parent
+
+	//eax: per-city adjacency (two slots each) of the parents' differing
+	//edges and of the child, and bookkeeping for AB-cycles and subtours
+	std::vector<int> onlyA, onlyB, child;
+	std::vector<int> path, pathPos;
+	std::vector<int> subtour, subtourSize, members;
+
+	CrossoverScratch() : mark(0) { }
+
+	//Starts a fresh mark over n cities; on wrap-around clears the stamps
+	//once
+	unsigned int nextMark(int n);
+};
+
+//The prefix operator, as used by crosslink
+void crosslinkOrders(const int *g1Order, const int *g2Order,
+                     int *orderOffspring, int genomeLength,
+                     CrossoverScratch &scratch);
+
+//Breeds g1 and g2 into offspring with the given operator. All orders
+//hold numPoints cities. dist, and the neighbour lists of neighbours if
+//not null, are only read by eax, to find where to join subtours. A new
+//operator needs a CrossoverKind, its name in crossoverName and
+//parseCrossover, and a case in this function's switch.
+void crossoverOrders(CrossoverKind kind, const int *g1Order,
+                     const int *g2Order, int *orderOffspring, int numPoints,
+                     const DistanceMatrix &dist, const LocalSearch *neighbours,
+                     CrossoverScratch &scratch);
+
+void orderCrossover(const int *g1Order, const int *g2Order,
+                    int *orderOffspring, int numPoints,
+                    CrossoverScratch &scratch);
+void partiallyMappedCrossover(const int *g1Order, const int *g2Order,
+                              int *orderOffspring, int numPoints,
+                              CrossoverScratch &scratch);
+void edgeAssemblyCrossover(const int *g1Order, const int *g2Order,
+                           int *orderOffspring, int numPoints,
+                           const DistanceMatrix &dist,
+                           const LocalSearch *neighbours,
+                           CrossoverScratch &scratch);
+
+//Name used on the command line and in benchmark output, and its inverse;
+//parseCrossover returns false for an unknown name
+const char *crossoverName(CrossoverKind kind);
+bool parseCrossover(const std::string &name, CrossoverKind &kind);
+
+#endif
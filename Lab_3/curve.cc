@@ -0,0 +1,169 @@
+#include "curve.hh"
+#include "parallel.hh"
+#include <algorithm>
+#include <utility>
+
+using namespace std;
+
+//Keys are computed and sorted in blocks of at least this many points
+const int CURVE_BLOCK = 1 << 16;
+
+uint64_t hilbertKey(uint32_t x, uint32_t y, uint32_t z) {
+	uint32_t X[3] = { x, y, z };
+	const uint32_t M = 1u << (CURVE_BITS - 1);
+
+	//Inverse undo excess work: where bit Q of X[i] is set, invert the low
+	//bits of X[0], else exchange them with X[i]'s. Branch-free, since the
+	//bits are as good as random.
+	for (uint32_t Q = M; Q > 1; Q >>= 1) {
+		uint32_t P = Q - 1;
+		for (int i = 0; i < 3; i++) {
+			uint32_t set = 0u - ((X[i] & Q) != 0);
+			uint32_t t = (X[0] ^ X[i]) & P & ~set;
+			X[0] ^= (P & set) | t;
+			X[i] ^= t;
+		}
+	}
+
+	//Gray encode
+	X[1] ^= X[0];
+	X[2] ^= X[1];
+	uint32_t t = 0;
+	for (uint32_t Q = M; Q > 1; Q >>= 1) {
+		if (X[2] & Q) t ^= Q - 1;
+	}
+	for (int i = 0; i < 3; i++) X[i] ^= t;
+
+	//The transposed bits interleaved are the key
+	return mortonKey(X[0], X[1], X[2]);
+}
+
+//The low CURVE_BITS bits of v spread to every third bit
+static inline uint64_t spreadBits(uint32_t v) {
+	uint64_t x = v & 0x1fffff;
+	x = (x | x << 32) & 0x1f00000000ffffULL;
+	x = (x | x << 16) & 0x1f0000ff0000ffULL;
+	x = (x | x << 8) & 0x100f00f00f00f00fULL;
+	x = (x | x << 4) & 0x10c30c30c30c30c3ULL;
+	x = (x | x << 2) & 0x1249249249249249ULL;
+	return x;
+}
+
+uint64_t mortonKey(uint32_t x, uint32_t y, uint32_t z) {
+	return spreadBits(x) << 2 | spreadBits(y) << 1 | spreadBits(z);
+}
+
+typedef pair<uint64_t, int> Keyed;   //curve key, point index
+
+//Sorts keyed: blocks in parallel, then rounds of pairwise merges into
+//buffer, the merges of a round in parallel. The ties on key are broken
+//by index, so any block split gives the same order.
+static void parallelSort(vector<Keyed> &keyed, int numThreads) {
+	const int n = (int) keyed.size();
+	int numBlocks = 1;
+	while (numBlocks < numThreads && (numBlocks * 2) * (int64_t) CURVE_BLOCK <= n) {
+		numBlocks *= 2;
+	}
+	auto blockStart = [&](int b) {
+		return (int) ((int64_t) n * b / numBlocks);
+	};
+	parallelFor(numBlocks, numThreads, [&](int b, int) {
+		sort(keyed.begin() + blockStart(b), keyed.begin() + blockStart(b + 1));
+	});
+	if (numBlocks == 1) return;
+
+	vector<Keyed> buffer(n);
+	for (int width = 1; width < numBlocks; width *= 2) {
+		parallelFor(numBlocks / (2 * width), numThreads, [&](int m, int) {
+			int lo = blockStart(2 * width * m);
+			int mid = blockStart(2 * width * m + width);
+			int hi = blockStart(2 * width * (m + 1));
+			merge(keyed.begin() + lo, keyed.begin() + mid,
+			      keyed.begin() + mid, keyed.begin() + hi, buffer.begin() + lo);
+		});
+		keyed.swap(buffer);
+	}
+}
+
+//The points in curve order. coord(i, axis) is coordinate axis of point
+//i; the grid covers twice the bounding cube so that a shift of up to one
+//extent (see curveOrder) stays inside.
+template <typename Coord>
+static void orderByCurve(int n, const Coord &coord, CurveKind kind,
+                         const double *shift, int numThreads, int *order) {
+	if (n == 0) return;
+
+	//One scale for all axes keeps the geometry
+	double low[3], high[3];
+	for (int a = 0; a < 3; a++) low[a] = high[a] = coord(0, a);
+	for (int i = 1; i < n; i++) {
+		for (int a = 0; a < 3; a++) {
+			double v = coord(i, a);
+			low[a] = min(low[a], v);
+			high[a] = max(high[a], v);
+		}
+	}
+	double extent = 0;
+	for (int a = 0; a < 3; a++) extent = max(extent, high[a] - low[a]);
+	const double cells = (double) ((1u << CURVE_BITS) - 1);
+	const double scale = extent > 0 ? cells / (2 * extent) : 0;
+	double offset[3];
+	for (int a = 0; a < 3; a++) offset[a] = shift ? shift[a] * extent : 0;
+
+	vector<Keyed> keyed(n);
+	int numBlocks = (n + CURVE_BLOCK - 1) / CURVE_BLOCK;
+	parallelFor(numBlocks, numThreads, [&](int b, int) {
+		int end = min(n, (b + 1) * CURVE_BLOCK);
+		for (int i = b * CURVE_BLOCK; i < end; i++) {
+			uint32_t c[3];
+			for (int a = 0; a < 3; a++) {
+				c[a] = (uint32_t) ((coord(i, a) - low[a] + offset[a]) * scale);
+			}
+			uint64_t key = kind == CURVE_MORTON ? mortonKey(c[0], c[1], c[2])
+			                                    : hilbertKey(c[0], c[1], c[2]);
+			keyed[i] = make_pair(key, i);
+		}
+	});
+	parallelSort(keyed, numThreads);
+	for (int i = 0; i < n; i++) order[i] = keyed[i].second;
+}
+
+void curveOrder(const PointCloud &cloud, int *order, const double *shift) {
+	const double *coords[3] = { cloud.xs(), cloud.ys(), cloud.zs() };
+	orderByCurve(cloud.size(),
+	             [&](int i, int a) { return coords[a][i]; },
+	             CURVE_HILBERT, shift, 1, order);
+}
+
+vector<int> curveTour(const vector<Point> &points, CurveKind kind,
+                      int numThreads) {
+	vector<int> order(points.size());
+	orderByCurve((int) points.size(),
+	             [&](int i, int a) {
+	               return a == 0 ? points[i].getX()
+	                             : a == 1 ? points[i].getY() : points[i].getZ();
+	             },
+	             kind, 0, numThreads, order.data());
+	return order;
+}
+
+vector<int> curveTour(const PointCloud &cloud, CurveKind kind,
+                      int numThreads) {
+	vector<int> order(cloud.size());
+	const double *coords[3] = { cloud.xs(), cloud.ys(), cloud.zs() };
+	orderByCurve(cloud.size(),
+	             [&](int i, int a) { return coords[a][i]; },
+	             kind, 0, numThreads, order.data());
+	return order;
+}
+
+const char *curveName(CurveKind kind) {
+	return kind == CURVE_MORTON ? "morton" : "hilbert";
+}
+
+bool parseCurve(const string &name, CurveKind &kind) {
+	if (name == "hilbert") kind = CURVE_HILBERT;
+	else if (name == "morton") kind = CURVE_MORTON;
+	else return false;
+	return true;
+}
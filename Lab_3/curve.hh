@@ -0,0 +1,54 @@
+//Space-filling curve orders over point sets
+#ifndef CURVE_HH
+#define CURVE_HH
+
+#include <vector>
+#include <string>
+#include <cstdint>
+#include "Point.hh"
+#include "PointCloud.hh"
+
+//Bits per axis of curve keys; three axes fill 63 bits of a key
+const int CURVE_BITS = 21;
+
+//Which curve orders the points:
+//  hilbert - 3D Hilbert curve: consecutive cells always share a face, so
+//            tours are shorter
+//  morton  - Z-order: the coordinate bits interleaved, cheaper to key
+//            but with long jumps between octants
+enum CurveKind {
+	CURVE_HILBERT,
+	CURVE_MORTON
+};
+
+//Position of grid cell (x, y, z), each coordinate below 2^CURVE_BITS,
+//along the curve. hilbertKey uses Skilling's transpose algorithm. Cells
+//close on either curve are close in space.
+uint64_t hilbertKey(uint32_t x, uint32_t y, uint32_t z);
+uint64_t mortonKey(uint32_t x, uint32_t y, uint32_t z);
+
+//Writes the points of cloud to order in Hilbert curve order, a tour
+//typically within 25% or so of nearest neighbour's length. The grid
+//covers twice the bounding cube; shift (three values in [0, 1), or null
+//for none) slides the points within it by that fraction of the cube,
+//which gives a different but equally local order.
+void curveOrder(const PointCloud &cloud, int *order,
+                const double *shift = 0);
+
+//The tour of points along the curve, for instances far too big for the
+//GA: O(n log n) and about 20 bytes per point beyond the points
+//themselves. Keys are computed and sorted in parallel on numThreads
+//threads; the result does not depend on numThreads.
+std::vector<int> curveTour(const std::vector<Point> &points,
+                           CurveKind kind = CURVE_HILBERT,
+                           int numThreads = 1);
+std::vector<int> curveTour(const PointCloud &cloud,
+                           CurveKind kind = CURVE_HILBERT,
+                           int numThreads = 1);
+
+//Name used on the command line, and its inverse; parseCurve returns
+//false for an unknown name
+const char *curveName(CurveKind kind);
+bool parseCurve(const std::string &name, CurveKind &kind);
+
+#endif
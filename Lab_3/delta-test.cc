@@ -0,0 +1,56 @@
+//Checks swapDelta and reverseDelta against a full recomputation of the
+//circuit for every pair of positions on random tours; prints each
+//mismatch and exits non-zero
+#include <iostream>
+#include <vector>
+#include <algorithm>
+#include <cmath>
+#include "tsp-ga.hh"
+
+using namespace std;
+
+static int failures = 0;
+
+static void check(double delta, double before, double after, const char *move,
+                  int n, int i, int j) {
+	if (fabs(before + delta - after) <= 1e-9 * max(1.0, after)) return;
+	cout << move << " mismatch: " << n << " points, positions " << i << " and "
+	     << j << ": delta " << delta << ", recomputed " << after - before << endl;
+	failures++;
+}
+
+int main() {
+	setThreadRng(Xoshiro256(1));
+	const int sizes[] = { 2, 3, 4, 5, 6, 7, 8, 13, 64 };
+	int moves = 0;
+	for (int n : sizes) {
+		vector<Point> points;
+		for (int i = 0; i < n; i++) {
+			points.push_back(Point(threadRng().nextInt(0, 1000),
+			                       threadRng().nextInt(0, 1000),
+			                       threadRng().nextInt(0, 1000)));
+		}
+		const DistanceMatrix dist(points);
+		vector<int> order(n), moved;
+		for (int tour = 0; tour < 4; tour++) {
+			randomOrder(order.data(), n);
+			const double before = dist.tourLength(order);
+			for (int i = 0; i < n; i++) {
+				for (int j = i + 1; j < n; j++) {
+					moved = order;
+					swap(moved[i], moved[j]);
+					check(swapDelta(order.data(), n, i, j, dist), before,
+					      dist.tourLength(moved), "swapDelta", n, i, j);
+
+					moved = order;
+					reverse(moved.begin() + i, moved.begin() + j + 1);
+					check(reverseDelta(order.data(), n, i, j, dist), before,
+					      dist.tourLength(moved), "reverseDelta", n, i, j);
+					moves += 2;
+				}
+			}
+		}
+	}
+	cout << moves << " moves, " << failures << " mismatches" << endl;
+	return failures ? 1 : 0;
+}
@@ -0,0 +1,118 @@
+//Checks KdTree queries against brute force on random instances, with
+//and without duplicate points; prints each mismatch and exits non-zero
+#include <iostream>
+#include <vector>
+#include <algorithm>
+#include <cmath>
+#include <utility>
+#include "KdTree.hh"
+#include "rng.hh"
+
+using namespace std;
+
+typedef pair<double, int> Candidate;   //squared distance, index
+
+static double distance2(const Point &p, double x, double y, double z) {
+	double dx = p.getX() - x, dy = p.getY() - y, dz = p.getZ() - z;
+	return dx * dx + dy * dy + dz * dz;
+}
+
+//Every point by distance from (x, y, z), ties broken by index
+static vector<Candidate> byDistance(const vector<Point> &points, double x,
+                                    double y, double z, int skip) {
+	vector<Candidate> all;
+	for (int i = 0; i < (int) points.size(); i++) {
+		if (i != skip) all.push_back(Candidate(distance2(points[i], x, y, z), i));
+	}
+	sort(all.begin(), all.end());
+	return all;
+}
+
+static vector<int> indices(const vector<Candidate> &candidates, size_t count) {
+	vector<int> result;
+	for (size_t i = 0; i < min(count, candidates.size()); i++) {
+		result.push_back(candidates[i].second);
+	}
+	return result;
+}
+
+static int failures = 0;
+
+static void check(bool ok, const char *query, int n, int q) {
+	if (ok) return;
+	cout << query << " mismatch: " << n << " points, query " << q << endl;
+	failures++;
+}
+
+//Grid coordinates make many equal distances, so ties get exercised
+static vector<Point> randomPoints(int n, bool grid, Xoshiro256 &rng) {
+	vector<Point> points;
+	for (int i = 0; i < n; i++) {
+		double c[3];
+		for (int a = 0; a < 3; a++) {
+			c[a] = grid ? rng.nextInt(0, 7) : rng.nextInt(0, 1 << 20) / 1024.0;
+		}
+		points.push_back(Point(c[0], c[1], c[2]));
+	}
+	return points;
+}
+
+static void checkInstance(const vector<Point> &points, double extent,
+                          int numThreads, Xoshiro256 &rng) {
+	const int n = (int) points.size();
+	const KdTree tree(points, numThreads);
+	const int ks[] = { 1, 2, 5, 16, n };
+	vector<int> result;
+
+	for (int q = 0; q < 20; q++) {
+		//Queries cover the points' box and a margin around it
+		double x = rng.nextInt(-64, 1088) / 1024.0 * extent;
+		double y = rng.nextInt(-64, 1088) / 1024.0 * extent;
+		double z = rng.nextInt(-64, 1088) / 1024.0 * extent;
+		vector<Candidate> all = byDistance(points, x, y, z, -1);
+		for (int k : ks) {
+			tree.nearest(x, y, z, k, result);
+			check(result == indices(all, k), "nearest", n, q);
+		}
+
+		//Radii at, between and beyond the distances that occur
+		double radii[3] = { 0, 0, 1e9 };
+		if (n > 0) {
+			radii[0] = sqrt(all[rng.nextInt(0, n - 1)].first);
+			radii[1] = radii[0] * 1.5;
+		}
+		for (double radius : radii) {
+			size_t inside = 0;
+			while (inside < all.size() && all[inside].first <= radius * radius) inside++;
+			tree.withinRadius(x, y, z, radius, result);
+			check(result == indices(all, inside), "withinRadius", n, q);
+		}
+	}
+
+	//The k nearest other points of each point
+	for (int i = 0; i < n; i += max(1, n / 50)) {
+		const Point &p = points[i];
+		vector<Candidate> others = byDistance(points, p.getX(), p.getY(), p.getZ(), i);
+		for (int k : ks) {
+			tree.nearest(i, k, result);
+			check(result == indices(others, k), "nearest other", n, i);
+		}
+	}
+}
+
+int main() {
+	Xoshiro256 rng(1);
+	const int sizes[] = { 0, 1, 2, 3, 7, 8, 9, 17, 100, 1000, 3000 };
+	int instances = 0;
+	for (int n : sizes) {
+		for (int grid = 0; grid < 2; grid++) {
+			for (int numThreads = 1; numThreads <= 4; numThreads *= 4) {
+				checkInstance(randomPoints(n, grid, rng), grid ? 7 : 1024, numThreads,
+				              rng);
+				instances++;
+			}
+		}
+	}
+	cout << instances << " instances, " << failures << " mismatches" << endl;
+	return failures ? 1 : 0;
+}
@@ -0,0 +1,124 @@
+//Minimal fork-join helper used by the multi-threaded solvers
+#ifndef PARALLEL_HH
+#define PARALLEL_HH
+
+#include <thread>
+#include <atomic>
+#include <vector>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+
+//Number of worker threads to use when the caller does not say
+inline int defaultThreadCount() {
+	int n = (int) std::thread::hardware_concurrency();
+	return n > 0 ? n : 1;
+}
+
+//Runs f(task, thread) for every task in [0, numTasks) on numThreads
+//threads. Tasks are handed out one at a time from a shared counter, so
+//uneven tasks still balance. Runs inline when one thread is enough.
+template <typename Func>
+void parallelFor(int numTasks, int numThreads, Func f) {
+	if (numThreads > numTasks) numThreads = numTasks;
+	if (numThreads <= 1) {
+		for (int t = 0; t < numTasks; t++) f(t, 0);
+		return;
+	}
+
+	std::atomic<int> next(0);
+	auto worker = [&](int thread) {
+		for (int t = next++; t < numTasks; t = next++) f(t, thread);
+	};
+
+	std::vector<std::thread> threads;
+	for (int i = 1; i < numThreads; i++) threads.push_back(std::thread(worker, i));
+	worker(0);
+	for (auto &th : threads) th.join();
+}
+
+//Fixed set of worker threads reused across many short parallel phases,
+//so a phase costs a wake-up instead of thread creation. run() has the
+//same contract as parallelFor; the calling thread works as thread 0.
+class ThreadPool {
+	private:
+		std::vector<std::thread> _threads;
+		std::mutex _mutex;
+		std::condition_variable _wake, _done;
+		const std::function<void(int, int)> *_job;   //owned by run()'s caller
+		std::atomic<int> _next;
+		int _numTasks;
+		int _running;              //workers still inside the current job
+		unsigned int _generation;  //bumped once per run()
+		bool _stop;
+
+		void work(int thread) {
+			for (int t = _next++; t < _numTasks; t = _next++) (*_job)(t, thread);
+		}
+
+		void workerLoop(int thread) {
+			unsigned int seen = 0;
+			for (;;) {
+				{
+					std::unique_lock<std::mutex> lock(_mutex);
+					_wake.wait(lock, [&] { return _stop || _generation != seen; });
+					if (_stop) return;
+					seen = _generation;
+				}
+				work(thread);
+				std::lock_guard<std::mutex> lock(_mutex);
+				if (--_running == 0) _done.notify_one();
+			}
+		}
+
+	public:
+		//Constructor: numThreads counts the caller, so numThreads-1 are spawned
+		explicit ThreadPool(int numThreads)
+				: _job(0), _next(0), _numTasks(0), _running(0), _generation(0),
+				  _stop(false) {
+			for (int i = 1; i < numThreads; i++) {
+				_threads.push_back(std::thread(&ThreadPool::workerLoop, this, i));
+			}
+		}
+
+		//Destructor
+		~ThreadPool() {
+			{
+				std::lock_guard<std::mutex> lock(_mutex);
+				_stop = true;
+			}
+			_wake.notify_all();
+			for (auto &th : _threads) th.join();
+		}
+
+		ThreadPool(const ThreadPool &) = delete;
+		ThreadPool &operator=(const ThreadPool &) = delete;
+
+		inline int size() const {
+			return (int) _threads.size() + 1;
+		}
+
+		//Runs f(task, thread) for every task in [0, numTasks) and returns
+		//once all are done. f is used in place, not copied, so passing the
+		//same std::function every time keeps a phase allocation-free.
+		void run(int numTasks, const std::function<void(int, int)> &f) {
+			if (_threads.empty() || numTasks <= 1) {
+				for (int t = 0; t < numTasks; t++) f(t, 0);
+				return;
+			}
+			{
+				std::lock_guard<std::mutex> lock(_mutex);
+				_job = &f;
+				_numTasks = numTasks;
+				_next = 0;
+				_running = (int) _threads.size();
+				_generation++;
+			}
+			_wake.notify_all();
+			work(0);
+			std::unique_lock<std::mutex> lock(_mutex);
+			_done.wait(lock, [&] { return _running == 0; });
+		}
+};
+
+#endif
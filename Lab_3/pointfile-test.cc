@@ -0,0 +1,96 @@
+//Round-trips random instances through the binary point format, in both
+//precisions and through both readers, and checks that damaged files are
+//rejected; prints each mismatch and exits non-zero
+#include <iostream>
+#include <fstream>
+#include <vector>
+#include <string>
+#include <cstdio>
+#include <unistd.h>
+#include "tsp-io.hh"
+#include "rng.hh"
+
+using namespace std;
+
+static int failures = 0;
+
+static void check(bool ok, const string &what) {
+	if (ok) return;
+	cout << what << endl;
+	failures++;
+}
+
+//A coordinate as it comes back from a file of the given precision
+static double stored(double v, bool singlePrecision) {
+	return singlePrecision ? (double) (float) v : v;
+}
+
+static bool samePoint(const Point &p, const Point &q, bool singlePrecision) {
+	return stored(p.getX(), singlePrecision) == q.getX() &&
+	       stored(p.getY(), singlePrecision) == q.getY() &&
+	       stored(p.getZ(), singlePrecision) == q.getZ();
+}
+
+static void roundTrip(const vector<Point> &points, bool singlePrecision,
+                      const string &path) {
+	const string name = to_string(points.size()) + " points, " +
+	                    (singlePrecision ? "float" : "double");
+	string error;
+	if (!writeBinaryPointFile(path, points, singlePrecision, error)) {
+		check(false, name + ": write failed: " + error);
+		return;
+	}
+
+	vector<Point> read;
+	if (!readPointFile(path, read, error)) {
+		check(false, name + ": readPointFile failed: " + error);
+	} else {
+		bool same = read.size() == points.size();
+		for (size_t i = 0; same && i < points.size(); i++) {
+			same = samePoint(points[i], read[i], singlePrecision);
+		}
+		check(same, name + ": readPointFile differs");
+	}
+
+	PointFile file;
+	if (!file.open(path, error)) {
+		check(false, name + ": PointFile failed: " + error);
+	} else {
+		const PointCloud &cloud = file.cloud();
+		bool same = cloud.size() == (int) points.size();
+		for (int i = 0; same && i < cloud.size(); i++) {
+			same = samePoint(points[i], cloud.getPoint(i), singlePrecision);
+		}
+		check(same, name + ": PointFile differs");
+	}
+
+	//Any file cut short must be refused by both readers
+	if (points.empty()) return;
+	ifstream in(path.c_str(), ios::in | ios::binary);
+	string bytes((istreambuf_iterator<char>(in)), istreambuf_iterator<char>());
+	ofstream(path.c_str(), ios::out | ios::binary | ios::trunc)
+		.write(bytes.data(), bytes.size() - 1);
+	check(!readPointFile(path, read, error), name + ": truncated file read");
+	PointFile truncated;
+	check(!truncated.open(path, error), name + ": truncated file opened");
+}
+
+int main() {
+	Xoshiro256 rng(1);
+	const string path = "/tmp/pointfile-test-" + to_string(getpid()) + ".pts";
+	const int sizes[] = { 0, 1, 3, 4, 5, 1000 };
+	for (int n : sizes) {
+		vector<Point> points;
+		for (int i = 0; i < n; i++) {
+			points.push_back(Point(rng.nextInt(-1 << 30, 1 << 30) / 1024.0,
+			                       rng.nextInt(-1 << 30, 1 << 30) / 3.0,
+			                       rng.nextInt(-1 << 30, 1 << 30) * 1e-7));
+		}
+		roundTrip(points, false, path);
+		roundTrip(points, true, path);
+	}
+	remove(path.c_str());
+	cout << 2 * sizeof(sizes) / sizeof(sizes[0]) << " round trips, " << failures
+	     << " mismatches" << endl;
+	return failures ? 1 : 0;
+}
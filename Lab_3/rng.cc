@@ -0,0 +1,75 @@
+#include "rng.hh"
+#include <random>
+#include <cassert>
+
+using namespace std;
+
+//splitmix64 expands one 64-bit seed into well-mixed state words
+static uint64_t splitmix64(uint64_t &x) {
+	uint64_t z = (x += 0x9e3779b97f4a7c15ULL);
+	z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+	z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+	return z ^ (z >> 31);
+}
+
+//Constructors
+Xoshiro256::Xoshiro256() {
+	random_device r;
+	uint64_t seed = ((uint64_t) r() << 32) ^ r();
+	for (int i = 0; i < 4; i++) _s[i] = splitmix64(seed);
+}
+
+Xoshiro256::Xoshiro256(uint64_t seed) {
+	for (int i = 0; i < 4; i++) _s[i] = splitmix64(seed);
+}
+
+//Member functions
+void Xoshiro256::jump() {
+	static const uint64_t JUMP[] = { 0x180ec6d33cfd0abaULL, 0xd5a61266f0c9392cULL,
+	                                 0xa9582618e03fc9aaULL, 0x39abdc4529b1661cULL };
+	uint64_t s[4] = { 0, 0, 0, 0 };
+	for (int i = 0; i < 4; i++) {
+		for (int b = 0; b < 64; b++) {
+			if (JUMP[i] & ((uint64_t) 1 << b)) {
+				for (int k = 0; k < 4; k++) s[k] ^= _s[k];
+			}
+			(*this)();
+		}
+	}
+	for (int k = 0; k < 4; k++) _s[k] = s[k];
+}
+
+int Xoshiro256::nextInt(int lo, int hi) {
+	assert(hi >= lo);
+
+	//Lemire's multiply-shift with rejection of the biased low range
+	uint64_t range = (uint64_t) ((int64_t) hi - lo) + 1;
+	uint64_t threshold = (0 - range) % range;
+	for (;;) {
+		unsigned __int128 m = (unsigned __int128) (*this)() * range;
+		if ((uint64_t) m >= threshold) return lo + (int) (m >> 64);
+	}
+}
+
+void Xoshiro256::getState(uint64_t state[4]) const {
+	for (int i = 0; i < 4; i++) state[i] = _s[i];
+}
+
+void Xoshiro256::setState(const uint64_t state[4]) {
+	for (int i = 0; i < 4; i++) _s[i] = state[i];
+}
+
+Xoshiro256 rngStream(uint64_t seed, int index) {
+	Xoshiro256 engine(seed);
+	for (int i = 0; i < index; i++) engine.jump();
+	return engine;
+}
+
+Xoshiro256 &threadRng() {
+	static thread_local Xoshiro256 engine;
+	return engine;
+}
+
+void setThreadRng(const Xoshiro256 &engine) {
+	threadRng() = engine;
+}
@@ -0,0 +1,68 @@
+//Random number generation for the genetic algorithm
+#ifndef RNG_HH
+#define RNG_HH
+
+#include <cstdint>
+
+//xoshiro256** (Blackman & Vigna): 32 bytes of state, a few cycles per
+//number, and a jump() that advances 2^128 steps so one seed can be split
+//into non-overlapping streams for parallel workers. Satisfies the
+//standard UniformRandomBitGenerator requirements.
+class Xoshiro256 {
+	private:
+		uint64_t _s[4];
+
+	public:
+		typedef uint64_t result_type;
+
+		//Constructors
+		Xoshiro256();                     //seeded from std::random_device
+		explicit Xoshiro256(uint64_t seed);
+
+		static constexpr result_type min() { return 0; }
+		static constexpr result_type max() { return UINT64_MAX; }
+
+		//Member functions
+		inline result_type operator()() {
+			const uint64_t result = rotl(_s[1] * 5, 7) * 9;
+			const uint64_t t = _s[1] << 17;
+			_s[2] ^= _s[0];
+			_s[3] ^= _s[1];
+			_s[1] ^= _s[2];
+			_s[0] ^= _s[3];
+			_s[2] ^= t;
+			_s[3] = rotl(_s[3], 45);
+			return result;
+		}
+
+		void jump();
+
+		//Uniform integer in [lo, hi], unbiased; needs hi >= lo
+		int nextInt(int lo, int hi);
+
+		//Uniform double in [0, 1)
+		inline double nextDouble() {
+			return ((*this)() >> 11) * (1.0 / 9007199254740992.0);
+		}
+
+		//Raw state access for checkpoints
+		void getState(uint64_t state[4]) const;
+		void setState(const uint64_t state[4]);
+
+	private:
+		static inline uint64_t rotl(uint64_t x, int k) {
+			return (x << k) | (x >> (64 - k));
+		}
+};
+
+//Stream `index` of `seed`: the seeded engine jumped `index` times. The
+//same (seed, index) always gives the same sequence.
+Xoshiro256 rngStream(uint64_t seed, int index);
+
+//The calling thread's engine. Each thread starts with its own engine
+//seeded from std::random_device; seed it with setThreadRng for
+//reproducible runs.
+Xoshiro256 &threadRng();
+void setThreadRng(const Xoshiro256 &engine);
+
+#endif
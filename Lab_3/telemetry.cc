@@ -0,0 +1,45 @@
+#include "telemetry.hh"
+#include <iomanip>
+
+using namespace std;
+
+TelemetryWriter::TelemetryWriter(ostream &out, TelemetryFormat format)
+		: _out(out), _format(format) {
+	if (_format == TELEMETRY_CSV) {
+		_out << "island,generation,best,mean,worst,diversity,select_s,"
+		     << "local_search_s,crossover_s,evaluate_s,mutate_s,total_s" << endl;
+	}
+}
+
+void TelemetryWriter::write(const GenerationStats &s) {
+	lock_guard<mutex> hold(_lock);
+	_out << setprecision(10);
+	if (_format == TELEMETRY_CSV) {
+		_out << s.island << "," << s.generation << "," << s.best << ","
+		     << s.mean << "," << s.worst << "," << s.diversity << ","
+		     << s.selectSeconds << "," << s.localSearchSeconds << ","
+		     << s.crossoverSeconds << "," << s.evaluateSeconds << ","
+		     << s.mutateSeconds << "," << s.totalSeconds << endl;
+	} else {
+		_out << "{\"island\":" << s.island << ",\"generation\":" << s.generation
+		     << ",\"best\":" << s.best << ",\"mean\":" << s.mean
+		     << ",\"worst\":" << s.worst << ",\"diversity\":" << s.diversity
+		     << ",\"select_s\":" << s.selectSeconds
+		     << ",\"local_search_s\":" << s.localSearchSeconds
+		     << ",\"crossover_s\":" << s.crossoverSeconds
+		     << ",\"evaluate_s\":" << s.evaluateSeconds
+		     << ",\"mutate_s\":" << s.mutateSeconds
+		     << ",\"total_s\":" << s.totalSeconds << "}" << endl;
+	}
+}
+
+const char *telemetryFormatName(TelemetryFormat format) {
+	return format == TELEMETRY_JSON ? "json" : "csv";
+}
+
+bool parseTelemetryFormat(const string &name, TelemetryFormat &format) {
+	if (name == "csv") format = TELEMETRY_CSV;
+	else if (name == "json") format = TELEMETRY_JSON;
+	else return false;
+	return true;
+}
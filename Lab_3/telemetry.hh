@@ -0,0 +1,72 @@
+//Per-generation statistics from the GA
+#ifndef TELEMETRY_HH
+#define TELEMETRY_HH
+
+#include <ostream>
+#include <string>
+#include <functional>
+#include <mutex>
+#include <chrono>
+
+//One generation of one population. Fitness is circuit length, so best
+//is the smallest. diversity is the mean share of edges the best tour
+//does not have in common with up to DIVERSITY_SAMPLE others spread over
+//the population: 0 when they all agree, near 1 for random tours.
+//The phase times are wall seconds: selection (ranking out the elite),
+//local search, crossover, evaluation (tour lengths) and mutation.
+//Breeding does crossover, evaluation and offspring local search on many
+//threads at once, so its wall time is split between them in proportion
+//to the time the threads spent on each.
+struct GenerationStats {
+	int island;           //0 without the island model
+	int generation;
+	double best, mean, worst;
+	double diversity;
+	double selectSeconds;
+	double localSearchSeconds;
+	double crossoverSeconds;
+	double evaluateSeconds;
+	double mutateSeconds;
+	double totalSeconds;
+};
+
+const int DIVERSITY_SAMPLE = 32;
+
+//Receives every generation's statistics. With islands it is called from
+//several worker threads, possibly at once.
+typedef std::function<void(const GenerationStats &)> TelemetryCallback;
+
+enum TelemetryFormat {
+	TELEMETRY_CSV,
+	TELEMETRY_JSON
+};
+
+//Seconds on a steady clock, for phase timing
+inline double telemetryClock() {
+	std::chrono::duration<double> t =
+			std::chrono::steady_clock::now().time_since_epoch();
+	return t.count();
+}
+
+//Writes statistics as CSV rows (after a header row) or JSON lines, one
+//per generation, flushing each. Safe to call from several threads.
+class TelemetryWriter {
+	private:
+		std::ostream &_out;
+		TelemetryFormat _format;
+		std::mutex _lock;
+
+	public:
+		//Constructors
+		TelemetryWriter(std::ostream &out, TelemetryFormat format);
+
+		//Member functions
+		void write(const GenerationStats &stats);
+};
+
+//Name used on the command line, and its inverse; parseTelemetryFormat
+//returns false for an unknown name
+const char *telemetryFormatName(TelemetryFormat format);
+bool parseTelemetryFormat(const std::string &name, TelemetryFormat &format);
+
+#endif
@@ -0,0 +1,50 @@
+//Converts instance files to the binary point format of tsp-io.hh
+#include <iostream>
+#include <vector>
+#include <string>
+#include <chrono>
+#include "tsp-io.hh"
+
+using namespace std;
+
+void usage(const char *progname);
+
+int main(int argc, char **argv) {
+  bool singlePrecision = false;
+  vector<string> paths;
+  for (int i = 1; i < argc; i++) {
+    string arg = argv[i];
+    if (arg == "--float") singlePrecision = true;
+    else paths.push_back(arg);
+  }
+  if (paths.size() != 2) {
+    usage(argv[0]);
+    return 1;
+  }
+
+  //Either format reads; the output is always binary
+  chrono::steady_clock::time_point start = chrono::steady_clock::now();
+  vector<Point> points;
+  string error;
+  if (!readPointFile(paths[0], points, error)) {
+    cerr << paths[0] << ": " << error << endl;
+    return 1;
+  }
+  chrono::duration<double> read = chrono::steady_clock::now() - start;
+  if (!writeBinaryPointFile(paths[1], points, singlePrecision, error)) {
+    cerr << paths[1] << ": " << error << endl;
+    return 1;
+  }
+  cout << paths[1] << ": " << points.size() << " points, "
+       << (singlePrecision ? "float" : "double") << " (read in "
+       << read.count() << " s)" << endl;
+  return 0;
+}
+
+void usage(const char *progname) {
+  cout << "Usage: " << progname << " [--float] input output.pts" << endl;
+  cout << "\ninput: instance in the text format (count, then x y z per point)"
+       << " or binary" << endl;
+  cout << "--float: store coordinates as floats, half the size but rounded"
+       << endl;
+}
@@ -0,0 +1,226 @@
+#include <iostream>
+#include <fstream>
+#include <vector>
+#include <string>
+#include <map>
+#include <cstdlib>
+#include <algorithm>
+#include "tsp-ga.hh"
+#include "tsp-io.hh"
+#include "bench.hh"
+
+using namespace std;
+
+map<string, double> readOptima(const string &path);
+string baseName(const string &path);
+string solverName(const GAOptions &options);
+void runScaling(unsigned int seed, double keepFraction, double mutationFactor,
+                bool json);
+void usage(const char *progname);
+
+int main(int argc, char **argv) {
+
+	int repeat = 3;
+	unsigned int seed = 1;
+	bool json = false;
+	bool scaling = false;
+	int population = 500, generations = 200;
+	double keepFraction = 0.3, mutationFactor = 0.1;
+	string optimaPath = "tests/optima.csv";
+	vector<int> generatedSizes = { 1000 };
+	vector<string> inputs;
+	GAOptions options;
+	options.showProgress = false;
+
+	for (int i = 1; i < argc; i++) {
+		string arg = argv[i];
+		if (arg == "--repeat" && i + 1 < argc) {
+			repeat = atoi(argv[++i]);
+		} else if (arg == "--seed" && i + 1 < argc) {
+			seed = (unsigned int) strtoul(argv[++i], 0, 10);
+		} else if (arg == "--ga" && i + 4 < argc) {
+			population = atoi(argv[++i]);
+			generations = atoi(argv[++i]);
+			keepFraction = atof(argv[++i]);
+			mutationFactor = atof(argv[++i]);
+		} else if (arg == "--crossover" && i + 1 < argc) {
+			if (!parseCrossover(argv[++i], options.crossover)) {
+				usage(argv[0]);
+				return 1;
+			}
+		} else if (arg == "--local-search" && i + 1 < argc) {
+			string mode = argv[++i];
+			if (mode == "none") options.localSearch = LOCAL_SEARCH_NONE;
+			else if (mode == "offspring") options.localSearch = LOCAL_SEARCH_OFFSPRING;
+			else if (mode == "elite") options.localSearch = LOCAL_SEARCH_ELITE;
+			else {
+				usage(argv[0]);
+				return 1;
+			}
+		} else if (arg == "--optima" && i + 1 < argc) {
+			optimaPath = argv[++i];
+		} else if (arg == "--no-generated") {
+			generatedSizes.clear();
+		} else if (arg == "--scaling") {
+			scaling = true;
+		} else if (arg == "--json") {
+			json = true;
+		} else if (arg[0] == '-') {
+			usage(argv[0]);
+			return 1;
+		} else {
+			inputs.push_back(arg);
+		}
+	}
+	const int keep = (int) (keepFraction * population);
+	if (repeat < 1 || population < 1 || generations < 1 || keep < 2 ||
+	    keep > population || mutationFactor < 0) {
+		usage(argv[0]);
+		return 1;
+	}
+	if (scaling) {
+		runScaling(seed, keepFraction, mutationFactor, json);
+		return 0;
+	}
+	map<string, double> optima = readOptima(optimaPath);
+
+	//Instances: the given files, then generated ones seeded from --seed
+	vector<string> names;
+	vector<vector<Point> > instances;
+	for (const string &path : listInstanceFiles(inputs)) {
+		vector<Point> points;
+		string error;
+		if (!readPointFile(path, points, error)) {
+			cerr << path << ": " << error << endl;
+			return 1;
+		}
+		names.push_back(path);
+		instances.push_back(points);
+	}
+	for (int n : generatedSizes) {
+		names.push_back("gen-" + to_string(n) + "-" + to_string(seed + n));
+		instances.push_back(generateInstance(n, seed + n));
+	}
+
+	writeBenchHeader(cout, json);
+	for (unsigned int k = 0; k < instances.size(); k++) {
+		const vector<Point> &points = instances[k];
+		if (points.size() < 3) continue;
+		map<string, double>::const_iterator known = optima.find(baseName(names[k]));
+
+		for (int run = 0; run < repeat; run++) {
+			options.seeded = true;
+			options.seed = seed + run;
+			Stopwatch timer;
+			TSPGenome best = findAShortPath(points, population, generations, keep,
+			                                (int) (mutationFactor * population),
+			                                options);
+			BenchRecord r;
+			r.seconds = timer.seconds();
+			r.suite = "ga";
+			r.instance = names[k];
+			r.solver = solverName(options);
+			r.points = (int) points.size();
+			r.run = run;
+			r.seed = seed + run;
+			//One evaluation per initial genome and per offspring
+			r.evaluations = population + (double) generations * (population - keep);
+			r.length = DistanceMatrix(points).tourLength(best.getOrder());
+			r.optimum = known == optima.end() ? -1 : known->second;
+			writeBenchRecord(cout, r, json);
+		}
+	}
+
+	return 0;
+}
+
+//Seconds per generation for large populations on a generated 100-point
+//instance, with each selection scheme. Setup is timed separately with a
+//zero-generation run and subtracted.
+void runScaling(unsigned int seed, double keepFraction, double mutationFactor,
+                bool json) {
+	const int n = 100, generations = 10;
+	const vector<Point> points = generateInstance(n, seed + n);
+	const SelectionKind selections[] = { SELECT_TRUNCATION, SELECT_TOURNAMENT };
+
+	writeBenchHeader(cout, json);
+	for (int population : { 10000, 30000, 100000 }) {
+		const int keep = max(2, (int) (keepFraction * population));
+		const int mutations = (int) (mutationFactor * population);
+		for (SelectionKind selection : selections) {
+			GAOptions options;
+			options.showProgress = false;
+			options.seeded = true;
+			options.seed = seed;
+			options.selection = selection;
+
+			Stopwatch setupTimer;
+			findAShortPath(points, population, 0, keep, mutations, options);
+			double setup = setupTimer.seconds();
+			Stopwatch timer;
+			TSPGenome best = findAShortPath(points, population, generations, keep,
+			                                mutations, options);
+			double total = timer.seconds();
+
+			BenchRecord r;
+			r.seconds = max(0.0, total - setup) / generations;
+			r.suite = "ga-scaling";
+			r.instance = "gen-" + to_string(n) + "-pop-" + to_string(population);
+			r.solver = selection == SELECT_TOURNAMENT ? "tournament" : "truncation";
+			r.points = n;
+			r.run = 0;
+			r.seed = seed;
+			r.evaluations = population - keep;   //offspring per generation
+			r.length = DistanceMatrix(points).tourLength(best.getOrder());
+			r.optimum = -1;
+			writeBenchRecord(cout, r, json);
+		}
+	}
+}
+
+//"ga", then "-<crossover>" unless it is the default prefix operator and
+//"+ls-<mode>" with local search
+string solverName(const GAOptions &options) {
+	string name = "ga";
+	if (options.crossover != CROSSOVER_PREFIX) {
+		name += string("-") + crossoverName(options.crossover);
+	}
+	if (options.localSearch == LOCAL_SEARCH_OFFSPRING) name += "+ls-offspring";
+	if (options.localSearch == LOCAL_SEARCH_ELITE) name += "+ls-elite";
+	return name;
+}
+
+//Reads "name,length" lines; '#' starts a comment line
+map<string, double> readOptima(const string &path) {
+	map<string, double> optima;
+	ifstream in(path.c_str());
+	string line;
+	while (getline(in, line)) {
+		size_t comma = line.find(',');
+		if (line.empty() || line[0] == '#' || comma == string::npos) continue;
+		optima[line.substr(0, comma)] = atof(line.c_str() + comma + 1);
+	}
+	return optima;
+}
+
+string baseName(const string &path) {
+	size_t slash = path.rfind('/');
+	return slash == string::npos ? path : path.substr(slash + 1);
+}
+
+void usage(const char *progname) {
+	cout << "Usage: " << progname << " [--repeat R] [--seed S]"
+			 << " [--ga population generations keep mutate]" << endl
+			 << "       [--crossover prefix|ox|pmx|eax]"
+			 << " [--local-search none|offspring|elite]" << endl
+			 << "       [--optima file.csv] [--no-generated] [--json] [file|dir ...]"
+			 << endl << "       " << progname << " --scaling [--seed S] [--json]"
+			 << endl;
+	cout << "\nRuns findAShortPath on each instance plus a generated 1000-point"
+			 << " instance" << endl << "and prints one CSV row (or JSON line) per"
+			 << " run. The gap is measured" << endl << "against the optima file"
+			 << " (default tests/optima.csv), keyed by file name." << endl;
+	cout << "\n--scaling instead times one generation at populations of 10^4 to"
+			 << " 10^5" << endl << "for each selection scheme (seconds column)."
+			 << endl;
+}
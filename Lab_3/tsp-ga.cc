@@ -2,17 +2,18 @@
 #include <iostream>
 #include <vector>
 #include <algorithm>
-#include <random>
-#include <set>
+#include <functional>
+#include <memory>
+#include <cmath>
+#include <cstdlib>
+#include <cassert>
 
 using namespace std;
 
 //Constructors
 TSPGenome::TSPGenome(const int numPoints) {
-	for (int i = 0; i < numPoints; i++) _order.push_back(i);
-  random_device r;
-  mt19937 g(r());
-	shuffle(_order.begin(), _order.end(), g);
+	_order.resize(numPoints);
+	randomOrder(_order.data(), numPoints);
 	_circuitLength = -1;
 }
 
@@ -47,45 +48,124 @@ void TSPGenome::computeCircuitLength(const vector<Point> &points) {
 	_circuitLength = cumuLength;
 }
 
+void TSPGenome::computeCircuitLength(const DistanceMatrix &dist) {
+	_circuitLength = dist.tourLength(_order);
+}
+
 void TSPGenome::mutate() {
+	mutateOrder(_order.data(), (int) _order.size());
+}
+
+void TSPGenome::mutate(const DistanceMatrix &dist, bool reverse) {
+	mutateOrder(_order.data(), (int) _order.size(), dist,
+	            reverse ? MUTATE_REVERSE : MUTATE_SWAP, _circuitLength);
+}
+
+void randomOrder(int *order, int numPoints) {
+	for (int i = 0; i < numPoints; i++) order[i] = i;
+
+	//Fisher-Yates on the thread's engine
+	Xoshiro256 &g = threadRng();
+	for (int i = numPoints - 1; i > 0; i--) swap(order[i], order[g.nextInt(0, i)]);
+}
+
+void mutateOrder(int *order, int numPoints) {
 
 	int swp1, swp2;
-	setTwoDiffRandInts(swp1, swp2, 0, (int) _order.size()-1);
+	setTwoDiffRandInts(swp1, swp2, 0, numPoints - 1);
 
 	//Mutate!
-  swap(_order[swp1], _order[swp2]);
+  swap(order[swp1], order[swp2]);
 }
 
-TSPGenome crosslink(const TSPGenome &g1, const TSPGenome &g2) {
+double swapDelta(const int *order, int numPoints, int i, int j,
+                 const DistanceMatrix &dist) {
+	//Every order of three or fewer cities is the same cycle
+	if (numPoints <= 3) return 0;
+	if (i > j) swap(i, j);
+	const int n = numPoints;
+	int a = order[i], b = order[j];
+	int pi = order[(i + n - 1) % n], ni = order[i + 1];
+	int pj = order[j - 1], nj = order[(j + 1) % n];
+
+	//Neighbours, directly or around the wrap: only two edges change
+	if (j == i + 1) return dist(pi, b) + dist(a, nj) - dist(pi, a) - dist(b, nj);
+	if (i == 0 && j == n - 1) return dist(pj, a) + dist(b, ni) - dist(pj, b) - dist(a, ni);
+
+	return dist(pi, b) + dist(b, ni) + dist(pj, a) + dist(a, nj)
+	     - dist(pi, a) - dist(a, ni) - dist(pj, b) - dist(b, nj);
+}
 
-	vector<int> g1Order = g1.getOrder();
-	vector<int> g2Order = g2.getOrder();
-	int genomeLength = (int) g1Order.size();
-	vector<int> orderOffspring;
+double reverseDelta(const int *order, int numPoints, int i, int j,
+                    const DistanceMatrix &dist) {
 
-	int cut;
-	setRandInt(cut, 0, genomeLength - 1);
-	set<int> s;
+	//Reversing everything (or everything but one city) leaves the cycle as is
+	if (j - i >= numPoints - 2) return 0;
+	int before = order[(i + numPoints - 1) % numPoints];
+	int after = order[(j + 1) % numPoints];
+	return dist(before, order[j]) + dist(order[i], after)
+	     - dist(before, order[i]) - dist(order[j], after);
+}
 
-	for (int i = 0; i < cut; i++)	{
-		orderOffspring.push_back(g1Order[i]);
-		s.insert(g1Order[i]);
+void mutateOrder(int *order, int numPoints, const DistanceMatrix &dist,
+                 MutationKind kind, double &length,
+                 const LocalSearch *neighbours) {
+
+	int i, j;
+	if (kind == MUTATE_NEIGHBOUR && neighbours && neighbours->numNeighbours() > 0) {
+
+		//City a at i and a near city c at j; reversing the stretch after a
+		//up to c (or from c up to just before a) makes them neighbours
+		setRandInt(i, 0, numPoints - 1);
+		int m;
+		setRandInt(m, 0, neighbours->numNeighbours() - 1);
+		int c = neighbours->neighbours(order[i])[m];
+		j = (int) (find(order, order + numPoints, c) - order);
+		if (i < j) {
+			i++;
+		} else {
+			swap(i, j);
+			j--;
+		}
+		if (i >= j) return;
+		kind = MUTATE_REVERSE;
+	} else {
+		setTwoDiffRandInts(i, j, 0, numPoints - 1);
+		if (i > j) swap(i, j);
 	}
 
-	for (int i = 0; i < (int) g2Order.size(); i++) {
-		if (!s.count(g2Order[i])) {
-			orderOffspring.push_back(g2Order[i]);
-			s.insert(g2Order[i]);
-		}
-		if ((int) orderOffspring.size() == genomeLength) break;
+	if (kind == MUTATE_REVERSE || kind == MUTATE_NEIGHBOUR) {
+		length += reverseDelta(order, numPoints, i, j, dist);
+		reverse(order + i, order + j + 1);
+	} else {
+		length += swapDelta(order, numPoints, i, j, dist);
+		swap(order[i], order[j]);
 	}
 
-	//Create TSPGnome offspring based on orderOffspring
-	TSPGenome offspring(orderOffspring);
+#ifdef TSP_GA_CHECK_DELTAS
+	double full = dist.tourLength(order, numPoints);
+	if (fabs(full - length) > 1e-9 * max(1.0, full)) {
+		cerr << "mutateOrder: incremental length " << length
+		     << " but full recomputation gives " << full << endl;
+		abort();
+	}
+#endif
+}
 
+TSPGenome crosslink(const TSPGenome &g1, const TSPGenome &g2) {
+	TSPGenome offspring(g1.getOrder());
+	CrossoverScratch scratch;
+	crosslink(g1, g2, offspring, scratch);
 	return offspring;
 }
 
+void crosslink(const TSPGenome &g1, const TSPGenome &g2, TSPGenome &offspring,
+               CrossoverScratch &scratch) {
+	crosslinkOrders(g1.getOrder().data(), g2.getOrder().data(),
+	                offspring.orderForWriting().data(),
+	                (int) g1.getOrder().size(), scratch);
+}
+
 bool isShorterPath(const TSPGenome &g1, const TSPGenome &g2) {
 	if (g1.getCircuitLength() < g2.getCircuitLength()) return true;
 	return false;
@@ -94,63 +174,578 @@ bool isShorterPath(const TSPGenome &g1, const TSPGenome &g2) {
 TSPGenome findAShortPath(const vector<Point> &points,
 		                     int populationSize, int numGenerations,
 												 int keepPopulation, int numMutations) {
-	
-	//Generate random population of genomes
-	vector<TSPGenome> population;
-	for (int i = 0; i < populationSize; i++) {
-		TSPGenome g((int) points.size());
-		g.computeCircuitLength(points);
-		population.push_back(g);
+	return findAShortPath(points, populationSize, numGenerations,
+	                      keepPopulation, numMutations, GAOptions());
+}
+
+//Fills the current generation with random tours and their lengths
+static void randomizePopulation(Population &population,
+                                const DistanceMatrix &dist) {
+	const int n = population.numPoints();
+	for (int i = 0; i < population.size(); i++) {
+		randomOrder(population.tour(i), n);
+		population.setFitness(i, dist.tourLength(population.tour(i), n));
+	}
+}
+
+//Genome i of the current generation as a TSPGenome
+static TSPGenome genomeAt(const Population &population, int i,
+                          const DistanceMatrix &dist) {
+	const int *tour = population.tour(i);
+	TSPGenome g(vector<int>(tour, tour + population.numPoints()));
+	g.computeCircuitLength(dist);
+	return g;
+}
+
+//Index of the shortest of size genomes drawn at random, repeats allowed;
+//exclude (if not -1) is never drawn, so the population needs two genomes
+static int tournamentWinner(const Population &population, int size,
+                            int exclude = -1) {
+	const int last = population.size() - (exclude >= 0 ? 2 : 1);
+	int best;
+	setRandInt(best, 0, last);
+	if (exclude >= 0 && best >= exclude) best++;
+	for (int t = 1; t < size; t++) {
+		int i;
+		setRandInt(i, 0, last);
+		if (exclude >= 0 && i >= exclude) i++;
+		if (population.fitness(i) < population.fitness(best) ||
+		    (population.fitness(i) == population.fitness(best) && i < best)) {
+			best = i;
+		}
 	}
+	return best;
+}
+
+//Offspring are bred in fixed chunks of this many genomes, each chunk
+//with its own RNG, so a seeded run is identical on any number of threads
+const int BREED_CHUNK = 64;
+
+static int numBreedChunks(int populationSize, int keepPopulation) {
+	return (populationSize - keepPopulation + BREED_CHUNK - 1) / BREED_CHUNK;
+}
 
-	for (int gen = 0; gen < numGenerations; gen++) { 
+int checkpointEngineCount(int populationSize, int keepPopulation,
+                          int numIslands) {
+	int numChunks = numBreedChunks(populationSize, keepPopulation);
+	if (numIslands > 1) return numIslands + 1 + numIslands * numChunks;
+	return 1 + numChunks;
+}
+
+//One RNG per breeding chunk, seeded from the calling thread's engine
+static vector<Xoshiro256> chunkEngines(int populationSize, int keepPopulation) {
+	int numChunks = numBreedChunks(populationSize, keepPopulation);
+	vector<Xoshiro256> engines;
+	for (int c = 0; c < numChunks; c++) engines.push_back(Xoshiro256(threadRng()()));
+	return engines;
+}
+
+//Fills the current generation as mix says: a block of genomes per
+//strategy, the first of each block in its plain form and the rest
+//randomized. Blocks are built in chunks of BREED_CHUNK genomes with an
+//engine each, drawn from the calling thread's, on the pool if one is
+//given. An all-random mix (or no builder) is the serial shuffle, so it
+//draws exactly what it always did.
+static void initializePopulation(Population &population,
+                                 const DistanceMatrix &dist,
+                                 const InitMix &mix,
+                                 const TourBuilder *builder,
+                                 ThreadPool *pool) {
+	if (!builder || mix.allRandom()) {
+		randomizePopulation(population, dist);
+		return;
+	}
+	const int populationSize = population.size();
+	const int n = population.numPoints();
+	int counts[NUM_INIT_STRATEGIES];
+	mix.counts(populationSize, counts);
+	vector<InitStrategy> strategy;
+	vector<bool> randomized;
+	for (int s = 0; s < NUM_INIT_STRATEGIES; s++) {
+		for (int c = 0; c < counts[s]; c++) {
+			strategy.push_back((InitStrategy) s);
+			randomized.push_back(c > 0);
+		}
+	}
+
+	vector<Xoshiro256> engines;
+	int numChunks = (populationSize + BREED_CHUNK - 1) / BREED_CHUNK;
+	for (int c = 0; c < numChunks; c++) engines.push_back(Xoshiro256(threadRng()()));
+	function<void(int, int)> buildChunk = [&](int c, int) {
+		Xoshiro256 saved = threadRng();
+		setThreadRng(engines[c]);
+		int end = min(populationSize, (c + 1) * BREED_CHUNK);
+		for (int i = c * BREED_CHUNK; i < end; i++) {
+			int *tour = population.tour(i);
+			switch (strategy[i]) {
+				case INIT_NEAREST_NEIGHBOUR:
+					builder->nearestNeighbour(tour, randomized[i]);
+					break;
+				case INIT_GREEDY:
+					builder->greedyEdge(tour, randomized[i]);
+					break;
+				case INIT_CURVE:
+					builder->curve(tour, randomized[i]);
+					break;
+				default:
+					randomOrder(tour, n);
+			}
+			population.setFitness(i, dist.tourLength(tour, n));
+		}
+		setThreadRng(saved);
+	};
+	if (pool) {
+		pool->run(numChunks, buildChunk);
+	} else {
+		for (int c = 0; c < numChunks; c++) buildChunk(c, 0);
+	}
+}
+
+//Fills in the fitness summary and diversity of stats (see telemetry.hh)
+//for the current generation; successor is n ints of scratch
+static void summarize(const Population &population, GenerationStats &stats,
+                      vector<int> &successor) {
+	const int size = population.size();
+	const int n = population.numPoints();
+	int best = 0;
+	double sum = 0, worst = population.fitness(0);
+	for (int i = 0; i < size; i++) {
+		double f = population.fitness(i);
+		sum += f;
+		worst = max(worst, f);
+		if (f < population.fitness(best)) best = i;
+	}
+	stats.best = population.fitness(best);
+	stats.mean = sum / size;
+	stats.worst = worst;
+
+	//Edges of the best tour that each sampled tour lacks, in either
+	//direction
+	stats.diversity = 0;
+	if (size < 2 || n < 2) return;
+	const int *tour = population.tour(best);
+	for (int i = 0; i < n; i++) successor[tour[i]] = tour[(i + 1) % n];
+	int samples = min(DIVERSITY_SAMPLE, size - 1);
+	double differing = 0;
+	for (int k = 0; k < samples; k++) {
+		int other = (best + 1 + (int) ((int64_t) k * (size - 1) / samples)) % size;
+		const int *t = population.tour(other);
+		int shared = 0;
+		for (int i = 0; i < n; i++) {
+			int a = t[i], b = t[(i + 1) % n];
+			if (successor[a] == b || successor[b] == a) shared++;
+		}
+		differing += 1.0 - (double) shared / n;
+	}
+	stats.diversity = differing / samples;
+}
+
+//Runs generations [firstGen, lastGen) on one population. Each
+//generation selects the elite of the current buffer, copies it to the
+//front of the next buffer and breeds the rest of it from the elite (or
+//from tournaments over the whole generation), then swaps.
+//Offspring chunks run on the pool if one is given, otherwise inline.
+//With localSearch set, offspring or the elite are improved as
+//options.localSearch says, and eax and neighbour mutation use its
+//candidate lists. Nothing is allocated per generation. With
+//options.telemetry set, each generation's statistics go to it, tagged
+//with island.
+static void evolve(Population &population, const DistanceMatrix &dist,
+                   int firstGen, int lastGen, int keepPopulation,
+                   int numMutations, const GAOptions &options, int island,
+                   bool showProgress, ThreadPool *pool,
+                   vector<Xoshiro256> &engines,
+                   const LocalSearch *localSearch) {
+
+	const int populationSize = population.size();
+	const int n = population.numPoints();
+	const bool tournament = options.selection == SELECT_TOURNAMENT;
+	const bool improveOffspring =
+			localSearch && options.localSearch == LOCAL_SEARCH_OFFSPRING;
+	const bool improveElite =
+			localSearch && options.localSearch == LOCAL_SEARCH_ELITE;
+	vector<CrossoverScratch> scratch(pool ? pool->size() : 1);
+	vector<LocalSearchScratch> searchScratch(localSearch ? scratch.size() : 0);
+
+	//Telemetry: per-thread seconds spent on each part of breeding
+	const bool telemetry = (bool) options.telemetry;
+	vector<double> crossoverTime, evaluateTime, searchTime;
+	vector<int> successor;
+	if (telemetry) {
+		crossoverTime.resize(scratch.size());
+		evaluateTime.resize(scratch.size());
+		searchTime.resize(scratch.size());
+		successor.resize(n);
+	}
+	function<void(int, int)> improveGenome = [&](int r, int thread) {
+		int i = population.ranked(r);
+		population.setFitness(i, localSearch->improve(population.tour(i), n,
+		                      population.fitness(i), searchScratch[thread]));
+	};
+	function<void(int, int)> breedChunk = [&](int c, int thread) {
+		Xoshiro256 saved = threadRng();
+		setThreadRng(engines[c]);
+		int end = min(populationSize, keepPopulation + (c + 1) * BREED_CHUNK);
+		for (int i = keepPopulation + c * BREED_CHUNK; i < end; i++) {
+			int p1, p2;
+			if (tournament) {
+				p1 = tournamentWinner(population, options.tournamentSize);
+				p2 = tournamentWinner(population, options.tournamentSize, p1);
+			} else {
+				setTwoDiffRandInts(p1, p2, 0, keepPopulation - 1);
+				p1 = population.ranked(p1);
+				p2 = population.ranked(p2);
+			}
+			int *child = population.nextTour(i);
+			double t0 = telemetry ? telemetryClock() : 0;
+			crossoverOrders(options.crossover, population.tour(p1),
+			                population.tour(p2), child, n, dist, localSearch,
+			                scratch[thread]);
+			double t1 = telemetry ? telemetryClock() : 0;
+			double length = dist.tourLength(child, n);
+			double t2 = telemetry ? telemetryClock() : 0;
+			if (improveOffspring) {
+				length = localSearch->improve(child, n, length, searchScratch[thread]);
+			}
+			population.setNextFitness(i, length);
+			if (telemetry) {
+				crossoverTime[thread] += t1 - t0;
+				evaluateTime[thread] += t2 - t1;
+				searchTime[thread] += telemetryClock() - t2;
+			}
+		}
+		engines[c] = threadRng();
+		setThreadRng(saved);
+	};
+
+	GenerationStats stats;
+	stats.island = island;
+	double start = 0, mark = 0;
+	auto lap = [&]() {
+		double now = telemetryClock(), elapsed = now - mark;
+		mark = now;
+		return elapsed;
+	};
+
+	for (int gen = firstGen; gen < lastGen; gen++) { 
+		if (telemetry) {
+			start = mark = telemetryClock();
+			fill(crossoverTime.begin(), crossoverTime.end(), 0.0);
+			fill(evaluateTime.begin(), evaluateTime.end(), 0.0);
+			fill(searchTime.begin(), searchTime.end(), 0.0);
+		}
 
-		//Sort by _circuitLength
-		sort(population.begin(), population.end(), isShorterPath);
+		//Select the elite by circuit length; nobody else needs an order. A
+		//memetic run polishes the elite and selects again.
+		population.rank(keepPopulation);
+		if (telemetry) stats.selectSeconds = lap();
+		if (improveElite) {
+			if (pool) {
+				pool->run(keepPopulation, improveGenome);
+			} else {
+				for (int r = 0; r < keepPopulation; r++) improveGenome(r, 0);
+			}
+			population.rank(keepPopulation);
+		}
+		if (telemetry) stats.localSearchSeconds = lap();
 		
-		//Print out progress
-		if (gen % 10 == 0) {
+		//Print out progress, untimed: neither a phase nor the total counts it
+		if (showProgress && gen % 10 == 0) {
 			cout << "Generation " << gen << ": Shortest path is "
-					 << population[0].getCircuitLength() << endl;
+					 << population.fitness(population.ranked(0)) << endl;
+			if (telemetry) start += lap();
 		}
 
 		//Keep top keepPopulation individuals, re-generate the rest
-		for (int i = keepPopulation; i < populationSize; i++) {
-			int p1, p2;
-			setTwoDiffRandInts(p1, p2, 0, keepPopulation - 1);
-			population[i] = crosslink(population[p1], population[p2]);
-      population[i].computeCircuitLength(points);
+		population.copyEliteToNext(keepPopulation);
+		if (pool) {
+			pool->run((int) engines.size(), breedChunk);
+		} else {
+			for (int c = 0; c < (int) engines.size(); c++) breedChunk(c, 0);
+		}
+		population.swapBuffers();
+
+		//Breeding's wall time, split by where the threads spent theirs
+		if (telemetry) {
+			double breed = lap(), crossover = 0, evaluate = 0, search = 0;
+			for (size_t t = 0; t < crossoverTime.size(); t++) {
+				crossover += crossoverTime[t];
+				evaluate += evaluateTime[t];
+				search += searchTime[t];
+			}
+			double busy = crossover + evaluate + search;
+			stats.crossoverSeconds = busy > 0 ? breed * crossover / busy : breed;
+			stats.evaluateSeconds = busy > 0 ? breed * evaluate / busy : 0;
+			stats.localSearchSeconds += busy > 0 ? breed * search / busy : 0;
 		}
 
-		//Apply numMutations mutations (except on the best)
+		//Apply numMutations mutations, updating each length by the edge
+		//delta. Slot 0 is spared: with an elite kept it holds the best;
+		//with keepPopulation 0 it is just the first child.
 		for (int i = 0; i < numMutations; i++) {
 			int m;
 			setRandInt(m, 1, populationSize - 1);
-			population[m].mutate();
+			double length = population.fitness(m);
+			mutateOrder(population.tour(m), n, dist, options.mutation, length,
+			            localSearch);
+			population.setFitness(m, length);
+		}
+
+		if (telemetry) {
+			stats.mutateSeconds = lap();
+			stats.totalSeconds = mark - start;
+			stats.generation = gen;
+			summarize(population, stats, successor);
+			options.telemetry(stats);
+		}
+	}
+	population.rank();
+}
+
+//Island model: each island evolves its own population on a worker
+//thread for migrationInterval generations, then every island sends
+//copies of its best migrationSize genomes to a neighbour, where they
+//replace the worst. Islands keep private RNG streams across epochs so a
+//seeded run gives the same result for any thread count.
+static TSPGenome findAShortPathIslands(const DistanceMatrix &dist,
+                                       int populationSize, int numGenerations,
+                                       int keepPopulation, int numMutations,
+                                       const GAOptions &options,
+                                       const LocalSearch *localSearch,
+                                       const TourBuilder *builder,
+                                       uint64_t pointsHash) {
+
+	const int numIslands = options.numIslands;
+	const int n = dist.size();
+	const int interval = max(1, options.migrationInterval);
+
+	//evolve leaves each island fully ranked, so emigrants come from the
+	//whole population even when nothing is kept between generations
+	const int migrants = min(options.migrationSize, populationSize);
+
+	vector<Population> islands;
+	vector<vector<Xoshiro256> > breedEngines(numIslands);
+	vector<Xoshiro256> engines;
+	for (int k = 0; k < numIslands; k++) {
+		islands.push_back(Population(populationSize, n));
+	}
+	for (int k = 0; k <= numIslands; k++) {
+		engines.push_back(options.seeded ? rngStream(options.seed, k + 1)
+		                                 : Xoshiro256());
+	}
+
+	//A resumed run takes every engine and population from the checkpoint,
+	//saved in the order the loop below writes them
+	int firstGen = 0;
+	if (options.resume) {
+		const Checkpoint &saved = *options.resume;
+		int e = 0;
+		for (int k = 0; k <= numIslands; k++) engines[k] = loadEngine(saved, e++);
+		for (int k = 0; k < numIslands; k++) {
+			int numChunks = numBreedChunks(populationSize, keepPopulation);
+			for (int c = 0; c < numChunks; c++) {
+				breedEngines[k].push_back(loadEngine(saved, e++));
+			}
+			loadPopulation(saved, k, islands[k]);
+		}
+		firstGen = saved.generation;
+	}
+	unique_ptr<CheckpointWriter> writer;
+	if (!options.checkpointPath.empty()) {
+		writer.reset(new CheckpointWriter(options.checkpointPath));
+	}
+	Checkpoint snapshot;
+	int lastSaved = firstGen;
+
+	//The last engine picks random migration targets. The caller's own
+	//engine is put back afterwards, since a worker may run on this thread.
+	Xoshiro256 &migrationRng = engines[numIslands];
+	const Xoshiro256 callerRng = threadRng();
+
+	for (int gen = firstGen; gen < numGenerations; gen += interval) {
+		int epochEnd = min(numGenerations, gen + interval);
+
+		//The state between epochs is the whole run
+		if (writer && gen - lastSaved >= options.checkpointInterval) {
+			beginCheckpoint(snapshot, gen, n, populationSize, keepPopulation,
+			                pointsHash);
+			for (const Xoshiro256 &engine : engines) saveEngine(snapshot, engine);
+			for (int k = 0; k < numIslands; k++) {
+				for (const Xoshiro256 &engine : breedEngines[k]) saveEngine(snapshot, engine);
+			}
+			for (int k = 0; k < numIslands; k++) savePopulation(snapshot, islands[k]);
+			writer->submit(snapshot);
+			lastSaved = gen;
+		}
+
+		parallelFor(numIslands, options.numThreads, [&](int k, int) {
+			setThreadRng(engines[k]);
+			if (gen == 0 && !options.resume) {
+				initializePopulation(islands[k], dist, options.initialMix, builder, 0);
+				breedEngines[k] = chunkEngines(populationSize, keepPopulation);
+			}
+			evolve(islands[k], dist, gen, epochEnd, keepPopulation, numMutations,
+			       options, k, false, 0, breedEngines[k], localSearch);
+			engines[k] = threadRng();
+		});
+
+		if (options.showProgress) {
+			double best = islands[0].fitness(islands[0].ranked(0));
+			for (int k = 1; k < numIslands; k++) {
+				best = min(best, islands[k].fitness(islands[k].ranked(0)));
+			}
+			cout << "Generation " << epochEnd << ": Shortest path is " << best
+					 << endl;
+		}
+		if (epochEnd == numGenerations || migrants < 1) continue;
+
+		//Snapshot every island's emigrants before anyone is overwritten
+		vector<vector<int> > outgoing(numIslands * migrants);
+		vector<double> outgoingLength(numIslands * migrants);
+		for (int k = 0; k < numIslands; k++) {
+			for (int i = 0; i < migrants; i++) {
+				const int *tour = islands[k].tour(islands[k].ranked(i));
+				outgoing[k * migrants + i].assign(tour, tour + n);
+				outgoingLength[k * migrants + i] = islands[k].fitness(islands[k].ranked(i));
+			}
+		}
+		for (int k = 0; k < numIslands; k++) {
+			int target = (k + 1) % numIslands;
+			if (options.topology == MIGRATE_RANDOM) {
+				target = migrationRng.nextInt(0, numIslands - 2);
+				if (target >= k) target++;
+			}
+			Population &dest = islands[target];
+			for (int i = 0; i < migrants; i++) {
+				int slot = dest.ranked(populationSize - 1 - i);
+				copy(outgoing[k * migrants + i].begin(), outgoing[k * migrants + i].end(),
+				     dest.tour(slot));
+				dest.setFitness(slot, outgoingLength[k * migrants + i]);
+			}
+		}
+	}
+
+	setThreadRng(callerRng);
+	if (firstGen >= numGenerations) {
+		for (int k = 0; k < numIslands; k++) islands[k].rank();
+	}
+	int bestIsland = 0;
+	for (int k = 1; k < numIslands; k++) {
+		if (islands[k].fitness(islands[k].ranked(0)) <
+		    islands[bestIsland].fitness(islands[bestIsland].ranked(0))) {
+			bestIsland = k;
 		}
 	}
+	return genomeAt(islands[bestIsland], islands[bestIsland].ranked(0), dist);
+}
+
+TSPGenome findAShortPath(const vector<Point> &points,
+		                     int populationSize, int numGenerations,
+												 int keepPopulation, int numMutations,
+												 const GAOptions &options) {
+	
+	//A single city has only one tour, and nothing to swap
+	if (points.size() < 2) {
+		TSPGenome only((int) points.size());
+		if (!points.empty()) only.computeCircuitLength(points);
+		return only;
+	}
 
-  sort(population.begin(), population.end(), isShorterPath);
-	return population[0];
+	//Truncation breeds two different parents from the elite
+	assert(options.selection != SELECT_TRUNCATION || keepPopulation >= 2);
+
+	//A seeded run draws everything from stream 0 of its seed
+	if (options.seeded) setThreadRng(rngStream(options.seed, 0));
+
+	//Every evaluation below reads from this table
+	DistanceMatrix dist(points, options.numThreads);
+
+	//Neighbour lists, only if local search, eax or mutation will read them
+	unique_ptr<LocalSearch> localSearch;
+	if (options.localSearch != LOCAL_SEARCH_NONE ||
+	    options.crossover == CROSSOVER_EAX ||
+	    options.mutation == MUTATE_NEIGHBOUR) {
+		localSearch.reset(new LocalSearch(dist, options.numNeighbours,
+		                                  options.numThreads,
+		                                  options.localSearchMoves));
+	}
+
+	//Construction heuristics for the first generation, unless it is all
+	//random or comes from a checkpoint
+	unique_ptr<TourBuilder> builder;
+	if (!options.initialMix.allRandom() && !options.resume) {
+		builder.reset(new TourBuilder(dist, options.numThreads));
+	}
+
+	const uint64_t pointsHash =
+			options.checkpointPath.empty() ? 0 : hashPoints(points);
+	if (options.numIslands > 1) {
+		return findAShortPathIslands(dist, populationSize, numGenerations,
+		                             keepPopulation, numMutations, options,
+		                             localSearch.get(), builder.get(),
+		                             pointsHash);
+	}
+
+	//Generate the first generation, or take it and the RNG states (this
+	//thread's engine first) from the checkpoint
+	const int n = (int) points.size();
+	Population population(populationSize, n);
+	ThreadPool pool(options.numThreads);
+	vector<Xoshiro256> engines;
+	int firstGen = 0;
+	if (options.resume) {
+		setThreadRng(loadEngine(*options.resume, 0));
+		int numChunks = numBreedChunks(populationSize, keepPopulation);
+		for (int c = 0; c < numChunks; c++) {
+			engines.push_back(loadEngine(*options.resume, c + 1));
+		}
+		loadPopulation(*options.resume, 0, population);
+		firstGen = options.resume->generation;
+	} else {
+		initializePopulation(population, dist, options.initialMix,
+		                     builder.get(), &pool);
+		engines = chunkEngines(populationSize, keepPopulation);
+	}
+
+	//Evolve in stretches of checkpointInterval generations, handing a
+	//snapshot to the writer thread after each one that is not the last
+	unique_ptr<CheckpointWriter> writer;
+	if (!options.checkpointPath.empty()) {
+		writer.reset(new CheckpointWriter(options.checkpointPath));
+	}
+	Checkpoint snapshot;
+	const int stretch = writer ? max(1, options.checkpointInterval) : numGenerations;
+	population.rank();
+	for (int gen = firstGen; gen < numGenerations; gen += stretch) {
+		int end = min(numGenerations, gen + stretch);
+		evolve(population, dist, gen, end, keepPopulation, numMutations,
+		       options, 0, options.showProgress, &pool, engines, localSearch.get());
+		if (writer && end < numGenerations) {
+			beginCheckpoint(snapshot, end, n, populationSize, keepPopulation,
+			                pointsHash);
+			saveEngine(snapshot, threadRng());
+			for (const Xoshiro256 &engine : engines) saveEngine(snapshot, engine);
+			savePopulation(snapshot, population);
+			writer->submit(snapshot);
+		}
+	}
+
+	return genomeAt(population, population.ranked(0), dist);
 }
 
 void setRandInt(int &i, const int start, const int end) {
-	random_device r;
-	mt19937 g(r());
-	uniform_int_distribution<int> rndInt(start, end);
-	i = rndInt(g);
+	i = threadRng().nextInt(start, end);
 }
 
 
 void setTwoDiffRandInts(int &i, int &j, const int start, const int end) {
-	random_device r;
-	mt19937 g(r());
-	uniform_int_distribution<int> rndInt(start, end);
-	i = 0, j = 0;
-	while (i == j) {
-		i = rndInt(g);
-		j = rndInt(g);
-	}
+	assert(end > start);
+
+	//Draw j from one fewer value and skip over i
+	Xoshiro256 &g = threadRng();
+	i = g.nextInt(start, end);
+	j = g.nextInt(start, end - 1);
+	if (j >= i) j++;
 }
 	
 
@@ -1,6 +1,15 @@
 //Header file for TSPGenome class
 #include <vector>
-#include "Point.hh"
+#include <string>
+#include <cstdint>
+#include "DistanceMatrix.hh"
+#include "Population.hh"
+#include "LocalSearch.hh"
+#include "crossover.hh"
+#include "construct.hh"
+#include "checkpoint.hh"
+#include "telemetry.hh"
+#include "rng.hh"
 
 class TSPGenome {
 	private:
@@ -11,14 +20,26 @@ class TSPGenome {
 		//Constructors
 		TSPGenome(const int numPoints);
 		TSPGenome(const std::vector<int> &order);
+		TSPGenome(const TSPGenome &other) = default;
+		TSPGenome(TSPGenome &&other) = default;
 		
 		//Destructor
 		~TSPGenome();
 
+		TSPGenome &operator=(const TSPGenome &other) = default;
+		TSPGenome &operator=(TSPGenome &&other) = default;
+
 		//Mutator methods
+
+		//Direct write access to the order, e.g. for in-place crossover;
+		//marks the cached length as stale
+		inline std::vector<int> &orderForWriting() {
+			_circuitLength = -1;
+			return _order;
+		}
 		
 		//Accessor methods
-		inline std::vector<int> getOrder() const {
+		inline const std::vector<int> &getOrder() const {
 			return _order;
 		}
 
@@ -28,16 +49,140 @@ class TSPGenome {
 		
 		//Member functions
 		void computeCircuitLength(const std::vector<Point> &points);
+		void computeCircuitLength(const DistanceMatrix &dist);
 		void mutate();
+
+		//Swap (or, with reverse set, 2-opt segment reversal) mutation that
+		//keeps the cached length exact by applying the edge delta
+		void mutate(const DistanceMatrix &dist, bool reverse = false);
+};
+
+//Mutation operator applied by findAShortPath: swap two cities, reverse
+//the segment between them (a random 2-opt move), or reverse the segment
+//that makes a random city adjacent to one of its nearest neighbours
+enum MutationKind {
+	MUTATE_SWAP,
+	MUTATE_REVERSE,
+	MUTATE_NEIGHBOUR
+};
+
+//Where island-model migrants go: the next island in a ring, or a
+//randomly chosen other island at every migration
+enum MigrationTopology {
+	MIGRATE_RING,
+	MIGRATE_RANDOM
+};
+
+//Which genomes get 2-opt/Or-opt local search: none, every offspring as
+//it is bred, or the elite of each generation (a memetic GA)
+enum LocalSearchMode {
+	LOCAL_SEARCH_NONE,
+	LOCAL_SEARCH_OFFSPRING,
+	LOCAL_SEARCH_ELITE
+};
+
+//How parents are picked: uniformly from the keepPopulation best
+//(truncation), or as the best of tournamentSize genomes drawn from the
+//whole population (the second parent's tournament leaves out the first;
+//needs a population of at least two)
+enum SelectionKind {
+	SELECT_TRUNCATION,
+	SELECT_TOURNAMENT
+};
+
+//Settings for findAShortPath beyond the basic GA parameters
+struct GAOptions {
+	int numThreads;       //worker threads for islands and setup work
+	bool showProgress;    //print the best length every 10 generations
+	bool seeded;          //if set, runs are reproducible from seed
+	uint64_t seed;
+	CrossoverKind crossover;
+	MutationKind mutation;
+	SelectionKind selection;
+	int tournamentSize;
+	LocalSearchMode localSearch;
+	LocalSearchMoves localSearchMoves;
+	int numNeighbours;    //candidate list length for local search
+	InitMix initialMix;   //construction heuristics for the first generation
+
+	//Island model: with numIslands > 1 each island evolves its own
+	//population of populationSize genomes and every migrationInterval
+	//generations sends copies of its best migrationSize to a neighbour
+	int numIslands;
+	int migrationInterval;
+	int migrationSize;
+	MigrationTopology topology;
+
+	//With checkpointPath set the run is saved there, in the background,
+	//every checkpointInterval generations (islands: at the first
+	//migration after that many). resume, if set, continues a saved run;
+	//it must pass checkpointMatches, which is the only check of its
+	//sizes and engine count, and the other options should be the ones it
+	//was started with.
+	std::string checkpointPath;
+	int checkpointInterval;
+	const Checkpoint *resume;
+
+	//Called with every generation's statistics if set; see telemetry.hh
+	TelemetryCallback telemetry;
+
+	GAOptions() : numThreads(defaultThreadCount()), showProgress(true),
+	              seeded(false), seed(0), crossover(CROSSOVER_PREFIX),
+	              mutation(MUTATE_SWAP),
+	              selection(SELECT_TRUNCATION), tournamentSize(3),
+	              localSearch(LOCAL_SEARCH_NONE), localSearchMoves(MOVES_2OPT),
+	              numNeighbours(8),
+	              numIslands(1), migrationInterval(20),
+	              migrationSize(2), topology(MIGRATE_RING),
+	              checkpointInterval(50), resume(0) { }
 };
 
 TSPGenome crosslink(const TSPGenome &g1, const TSPGenome &g2);
 
+//Writes the crossover of g1 and g2 into offspring, whose order must
+//already hold g1.getOrder().size() cities. Allocates nothing once scratch
+//and offspring have been sized by a first call.
+void crosslink(const TSPGenome &g1, const TSPGenome &g2, TSPGenome &offspring,
+               CrossoverScratch &scratch);
+
+//The same operators on raw orders of numPoints cities, as stored in a
+//Population
+void randomOrder(int *order, int numPoints);
+void mutateOrder(int *order, int numPoints);
+
+//Change in circuit length from swapping positions i and j, or from
+//reversing the segment [i, j] (i < j); O(1), only the edges at the ends
+//move
+double swapDelta(const int *order, int numPoints, int i, int j,
+                 const DistanceMatrix &dist);
+double reverseDelta(const int *order, int numPoints, int i, int j,
+                    const DistanceMatrix &dist);
+
+//Random swap or segment reversal that adds its delta to length.
+//MUTATE_NEIGHBOUR draws from the candidate lists of neighbours and falls
+//back to MUTATE_REVERSE without them. Built with TSP_GA_CHECK_DELTAS,
+//each update is checked against a full recomputation.
+void mutateOrder(int *order, int numPoints, const DistanceMatrix &dist,
+                 MutationKind kind, double &length,
+                 const LocalSearch *neighbours = 0);
+
 bool isShorterPath(const TSPGenome &g1, const TSPGenome &g2);
 
 TSPGenome findAShortPath(const std::vector<Point> &points,
 		                     int populationSize, int numGenerations,
 												 int keepPopulation, int numMutations);
+TSPGenome findAShortPath(const std::vector<Point> &points,
+		                     int populationSize, int numGenerations,
+												 int keepPopulation, int numMutations,
+												 const GAOptions &options);
+
+//How many RNG states a checkpoint of findAShortPath with these sizes
+//holds: the driving engine and one per breeding chunk, or with islands
+//one per island plus the migration engine and each island's chunks
+int checkpointEngineCount(int populationSize, int keepPopulation,
+                          int numIslands);
 
+//Uniform integers in [start, end] from the thread's engine; the two
+//differ, so setTwoDiffRandInts needs end > start
 void setRandInt(int &i, const int start, const int end);
 void setTwoDiffRandInts(int &i, int &j, const int start, const int end);
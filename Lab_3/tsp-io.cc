@@ -0,0 +1,321 @@
+#include "tsp-io.hh"
+#include "PointCloud.hh"
+#include "parallel.hh"
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cerrno>
+#include <cassert>
+#include <cstring>
+#include <cstdint>
+#include <climits>
+#include <dirent.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+
+using namespace std;
+
+//Binary point file header; see tsp-io.hh
+static const char POINT_FILE_MAGIC[8] = { 'T', 'S', 'P', 'P', 'T', 'S', '1', 0 };
+
+struct PointFileHeader {
+	char magic[8];
+	uint64_t count;
+	uint32_t scalarSize;
+	uint32_t stride;
+	char reserved[40];
+};
+
+static_assert(sizeof(PointFileHeader) == 64, "point file header is 64 bytes");
+
+//The text format
+static bool readTextPointFile(const string &path, vector<Point> &points,
+                              string &error) {
+
+	//Slurp the file; one read beats thousands of formatted extractions
+	ifstream in(path.c_str(), ios::in | ios::binary);
+	if (!in) {
+		error = "cannot open file";
+		return false;
+	}
+	string text((istreambuf_iterator<char>(in)), istreambuf_iterator<char>());
+
+	const char *cur = text.c_str();
+	char *end;
+	errno = 0;
+	long count = strtol(cur, &end, 10);
+	if (end == cur || count < 0 || errno) {
+		error = "missing point count";
+		return false;
+	}
+	cur = end;
+
+	//The count is untrusted; every point takes at least six characters,
+	//so never reserve more than the text could hold
+	points.clear();
+	points.reserve(min(count, (long) text.size() / 6));
+	for (long i = 0; i < count; i++) {
+		double coords[3];
+		for (int c = 0; c < 3; c++) {
+			coords[c] = strtod(cur, &end);
+			if (end == cur) {
+				error = "expected " + to_string(count) + " points, read " +
+				        to_string(i);
+				return false;
+			}
+			cur = end;
+		}
+		points.push_back(Point(coords[0], coords[1], coords[2]));
+	}
+	return true;
+}
+
+bool readPointFile(const string &path, vector<Point> &points, string &error) {
+
+	//Binary files go through a mapping
+	ifstream in(path.c_str(), ios::in | ios::binary);
+	char magic[sizeof(POINT_FILE_MAGIC)] = { 0 };
+	in.read(magic, sizeof(magic));
+	if (!in || memcmp(magic, POINT_FILE_MAGIC, sizeof(magic)) != 0) {
+		return readTextPointFile(path, points, error);
+	}
+	PointFile file;
+	if (!file.open(path, error)) return false;
+	const PointCloud &cloud = file.cloud();
+	points.clear();
+	points.reserve(cloud.size());
+	for (int i = 0; i < cloud.size(); i++) points.push_back(cloud.getPoint(i));
+	return true;
+}
+
+bool writeBinaryPointFile(const string &path, const vector<Point> &points,
+                          bool singlePrecision, string &error) {
+	PointFileHeader header;
+	memset(&header, 0, sizeof(header));
+	memcpy(header.magic, POINT_FILE_MAGIC, sizeof(header.magic));
+	header.count = points.size();
+	header.scalarSize = singlePrecision ? sizeof(float) : sizeof(double);
+	header.stride = PointCloud::paddedStride((int) points.size());
+
+	ofstream out(path.c_str(), ios::out | ios::binary | ios::trunc);
+	if (!out) {
+		error = "cannot create file";
+		return false;
+	}
+	out.write((const char *) &header, sizeof(header));
+
+	//One coordinate block at a time, zero padded to the stride
+	const PointCloud cloud(points);
+	const double *blocks[3] = { cloud.xs(), cloud.ys(), cloud.zs() };
+	vector<float> narrow(singlePrecision ? header.stride : 0);
+	for (int a = 0; a < 3; a++) {
+		if (singlePrecision) {
+			for (uint32_t i = 0; i < header.stride; i++) narrow[i] = (float) blocks[a][i];
+			out.write((const char *) narrow.data(), header.stride * sizeof(float));
+		} else {
+			out.write((const char *) blocks[a], header.stride * sizeof(double));
+		}
+	}
+	if (!out.flush()) {
+		error = "write failed";
+		return false;
+	}
+	return true;
+}
+
+PointFile::PointFile() : _map(0), _mapSize(0) {
+}
+
+PointFile::~PointFile() {
+	unmap();
+}
+
+void PointFile::unmap() {
+	_cloud = PointCloud();
+	if (_map) munmap(_map, _mapSize);
+	_map = 0;
+	_mapSize = 0;
+}
+
+bool PointFile::open(const string &path, string &error) {
+	unmap();
+	int fd = ::open(path.c_str(), O_RDONLY);
+	if (fd < 0) {
+		error = "cannot open file";
+		return false;
+	}
+	struct stat info;
+	bool binary = false;
+	if (fstat(fd, &info) == 0 && info.st_size >= (off_t) sizeof(PointFileHeader)) {
+		void *map = mmap(0, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+		if (map != MAP_FAILED) {
+			_map = map;
+			_mapSize = info.st_size;
+			binary = memcmp(map, POINT_FILE_MAGIC, sizeof(POINT_FILE_MAGIC)) == 0;
+		}
+	}
+	close(fd);
+
+	//Text: parse it like any other instance
+	if (!binary) {
+		unmap();
+		vector<Point> points;
+		if (!readTextPointFile(path, points, error)) return false;
+		_cloud = PointCloud(points);
+		return true;
+	}
+
+	PointFileHeader header;
+	memcpy(&header, _map, sizeof(header));
+	const bool isDouble = header.scalarSize == sizeof(double);
+	if ((!isDouble && header.scalarSize != sizeof(float)) ||
+	    header.count > (uint64_t) INT_MAX ||
+	    header.stride != (uint64_t) PointCloud::paddedStride((int) header.count)) {
+		unmap();
+		error = "bad binary point file header";
+		return false;
+	}
+	if (_mapSize < sizeof(header) + 3 * (uint64_t) header.stride * header.scalarSize) {
+		unmap();
+		error = "binary point file is truncated";
+		return false;
+	}
+
+	//Doubles are viewed where they lie; floats are widened into a cloud
+	//of our own and the mapping dropped
+	const char *data = (const char *) _map + sizeof(header);
+	const int n = (int) header.count;
+	if (isDouble) {
+		_cloud = PointCloud((const double *) data, n);
+		assert(_cloud.xs() == (const double *) data);
+		return true;
+	}
+	vector<double> wide(3 * (size_t) header.stride);
+	const float *narrow = (const float *) data;
+	for (size_t i = 0; i < wide.size(); i++) wide[i] = narrow[i];
+	PointCloud cloud(wide.data(), n);
+	unmap();
+	_cloud = PointCloud(cloud);
+	return true;
+}
+
+static bool hasSuffix(const string &s, const string &suffix) {
+	return s.size() >= suffix.size() &&
+	       s.compare(s.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+vector<string> listInstanceFiles(const vector<string> &args) {
+	vector<string> files;
+	for (const string &arg : args) {
+		struct stat info;
+		if (stat(arg.c_str(), &info) != 0 || !S_ISDIR(info.st_mode)) {
+			files.push_back(arg);
+			continue;
+		}
+
+		//Directory: take its instance entries in name order
+		vector<string> entries;
+		DIR *dir = opendir(arg.c_str());
+		if (!dir) continue;
+		for (struct dirent *e = readdir(dir); e; e = readdir(dir)) {
+			string name = e->d_name;
+			if (hasSuffix(name, ".txt") || hasSuffix(name, ".pts")) {
+				entries.push_back(name);
+			}
+		}
+		closedir(dir);
+		sort(entries.begin(), entries.end());
+
+		string prefix = hasSuffix(arg, "/") ? arg : arg + "/";
+		for (const string &name : entries) files.push_back(prefix + name);
+	}
+	return files;
+}
+
+//Times solve on cloud and appends "points, length, seconds, tour" to
+//line; false if the solver gave back a wrong-sized order
+static bool formatSolution(ostream &line, const PointCloud &cloud,
+                           const function<vector<int>()> &solve) {
+	chrono::steady_clock::time_point start = chrono::steady_clock::now();
+	vector<int> order = solve();
+	chrono::duration<double> elapsed = chrono::steady_clock::now() - start;
+
+	if ((int) order.size() != cloud.size()) {
+		line << "error\tsolver declined instance";
+		return false;
+	}
+	line << order.size() << "\t" << setprecision(10)
+	     << cloud.tourLength(order.data(), (int) order.size()) << "\t"
+	     << setprecision(6) << elapsed.count() << "\t";
+	for (unsigned int i = 0; i < order.size(); i++) {
+		line << (i ? "," : "") << order[i];
+	}
+	return true;
+}
+
+//Runs solveOne(path, line) for every path on numThreads workers, each
+//writing one result line; false marks a failure. Lines are printed in
+//input order.
+static int runTasks(const vector<string> &paths, int numThreads,
+                    const function<bool(const string &, ostream &)> &solveOne,
+                    ostream &out) {
+	vector<string> lines(paths.size());
+	vector<char> failed(paths.size(), false);
+
+	parallelFor((int) paths.size(), numThreads, [&](int task, int) {
+		ostringstream line;
+		line << paths[task] << "\t";
+		failed[task] = !solveOne(paths[task], line);
+		lines[task] = line.str();
+	});
+
+	int numFailed = 0;
+	out << "#path\tpoints\tlength\tseconds\ttour" << endl;
+	for (unsigned int i = 0; i < lines.size(); i++) {
+		out << lines[i] << "\n";
+		if (failed[i]) numFailed++;
+	}
+	out.flush();
+	return numFailed;
+}
+
+int runBatch(const vector<string> &paths, int numThreads,
+             const BatchSolver &solve, ostream &out) {
+	return runTasks(paths, numThreads, [&](const string &path, ostream &line) {
+		vector<Point> points;
+		string error;
+		if (!readPointFile(path, points, error)) {
+			line << "error\t" << error;
+			return false;
+		}
+		if (points.empty()) {
+			line << "error\tno points";
+			return false;
+		}
+		return formatSolution(line, PointCloud(points),
+		                      [&]() { return solve(points); });
+	}, out);
+}
+
+int runCloudBatch(const vector<string> &paths, int numThreads,
+                  const CloudSolver &solve, ostream &out) {
+	return runTasks(paths, numThreads, [&](const string &path, ostream &line) {
+		PointFile file;
+		string error;
+		if (!file.open(path, error)) {
+			line << "error\t" << error;
+			return false;
+		}
+		if (file.cloud().size() == 0) {
+			line << "error\tno points";
+			return false;
+		}
+		return formatSolution(line, file.cloud(),
+		                      [&]() { return solve(file.cloud()); });
+	}, out);
+}
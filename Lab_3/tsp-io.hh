@@ -0,0 +1,82 @@
+//Header file for reading TSP instance files and solving them in batches
+#ifndef TSP_IO_HH
+#define TSP_IO_HH
+
+#include <vector>
+#include <string>
+#include <ostream>
+#include <functional>
+#include "Point.hh"
+#include "PointCloud.hh"
+
+//Reads an instance in the tests/test-*.txt format: a point count, then
+//"x y z" for each point, whitespace separated. The whole file is read in
+//one go and parsed with strtod. Binary point files (below) are accepted
+//too. Returns false and sets error on failure.
+bool readPointFile(const std::string &path, std::vector<Point> &points,
+                   std::string &error);
+
+//Binary point files (*.pts): a 64-byte header - the magic "TSPPTS1" and
+//a NUL, the point count as a uint64, bytes per coordinate (8 for double,
+//4 for float) and the stride as uint32s, zeros - then all x coordinates,
+//all y and all z, each block stride values long (the count rounded up to
+//a multiple of four, zero padded). That is a PointCloud's layout, so a
+//double file is used where it is mapped. Native byte order.
+bool writeBinaryPointFile(const std::string &path,
+                          const std::vector<Point> &points,
+                          bool singlePrecision, std::string &error);
+
+//An instance file of either format as a PointCloud. A double binary
+//file is mapped read-only and viewed in place, so opening it costs
+//milliseconds at any size; a float file is mapped and widened, a text
+//file parsed. The cloud lives as long as the PointFile.
+class PointFile {
+	private:
+		void *_map;
+		size_t _mapSize;
+		PointCloud _cloud;
+
+		void unmap();
+
+	public:
+		//Constructors
+		PointFile();
+		PointFile(const PointFile &) = delete;
+		PointFile &operator=(const PointFile &) = delete;
+
+		//Destructor
+		~PointFile();
+
+		//Accessor methods
+		inline const PointCloud &cloud() const {
+			return _cloud;
+		}
+
+		//Member functions
+
+		//Returns false and sets error on failure
+		bool open(const std::string &path, std::string &error);
+};
+
+//Expands the given files and directories into a sorted list of instance
+//files; directories contribute every *.txt and *.pts file directly
+//inside them.
+std::vector<std::string> listInstanceFiles(const std::vector<std::string> &args);
+
+//Solves one instance and returns the visiting order
+typedef std::function<std::vector<int>(const std::vector<Point> &)> BatchSolver;
+typedef std::function<std::vector<int>(const PointCloud &)> CloudSolver;
+
+//Solves every file on numThreads workers and writes one tab-separated line
+//per instance, in input order: path, points, length, seconds, tour (comma
+//separated), or path followed by "error" and a message. Returns the number
+//of instances that failed.
+int runBatch(const std::vector<std::string> &paths, int numThreads,
+             const BatchSolver &solve, std::ostream &out);
+
+//The same for solvers that work on a PointCloud, which binary files
+//hand over without a copy
+int runCloudBatch(const std::vector<std::string> &paths, int numThreads,
+             const CloudSolver &solve, std::ostream &out);
+
+#endif
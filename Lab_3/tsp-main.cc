@@ -2,7 +2,13 @@
 #include <vector>
 #include <algorithm>
 #include <cstdlib>
+#include <string>
+#include <fstream>
+#include <memory>
 #include "tsp-ga.hh"
+#include "anneal.hh"
+#include "tsp-io.hh"
+#include "curve.hh"
 
 using namespace std;
 
@@ -11,23 +17,196 @@ void usage(const char *progname);
 
 int main(int argc, char **argv) {
 
-	//Variables to hold user input points
-  if (argc != 5) {
+  //Split the command line into the four GA parameters and options;
+  //anything after --batch is an instance file or directory. With --curve
+  //or --anneal the GA is skipped and the parameters may be left out.
+  vector<string> params, batchArgs;
+  GAOptions options;
+  string resumePath, telemetryPath;
+  TelemetryFormat telemetryFormat = TELEMETRY_CSV;
+  bool telemetryFormatSet = false;
+  bool batch = false, badOption = false, polish = false, curveOnly = false;
+  CurveKind curve = CURVE_HILBERT;
+  AnnealOptions annealOptions;
+  bool annealing = false;
+  for (int i = 1; i < argc; i++) {
+    string arg = argv[i];
+    bool hasValue = i + 1 < argc;
+    if (arg == "--threads" && hasValue) {
+      options.numThreads = atoi(argv[++i]);
+    } else if (arg == "--seed" && hasValue) {
+      options.seed = strtoull(argv[++i], 0, 10);
+      options.seeded = true;
+    } else if (arg == "--crossover" && hasValue) {
+      if (!parseCrossover(argv[++i], options.crossover)) badOption = true;
+    } else if (arg == "--init" && hasValue) {
+      if (!parseInitMix(argv[++i], options.initialMix)) badOption = true;
+    } else if (arg == "--mutation" && hasValue) {
+      string mutation = argv[++i];
+      if (mutation == "swap") options.mutation = MUTATE_SWAP;
+      else if (mutation == "reverse") options.mutation = MUTATE_REVERSE;
+      else if (mutation == "neighbour") options.mutation = MUTATE_NEIGHBOUR;
+      else badOption = true;
+    } else if (arg == "--selection" && hasValue) {
+      string selection = argv[++i];
+      if (selection == "truncation") options.selection = SELECT_TRUNCATION;
+      else if (selection == "tournament") options.selection = SELECT_TOURNAMENT;
+      else badOption = true;
+    } else if (arg == "--tournament-size" && hasValue) {
+      options.tournamentSize = atoi(argv[++i]);
+      if (options.tournamentSize < 1) badOption = true;
+    } else if (arg == "--local-search" && hasValue) {
+      string mode = argv[++i];
+      if (mode == "none") options.localSearch = LOCAL_SEARCH_NONE;
+      else if (mode == "offspring") options.localSearch = LOCAL_SEARCH_OFFSPRING;
+      else if (mode == "elite") options.localSearch = LOCAL_SEARCH_ELITE;
+      else badOption = true;
+    } else if (arg == "--ls-moves" && hasValue) {
+      string moves = argv[++i];
+      if (moves == "2opt") options.localSearchMoves = MOVES_2OPT;
+      else if (moves == "lk") options.localSearchMoves = MOVES_LIN_KERNIGHAN;
+      else badOption = true;
+    } else if (arg == "--curve" && hasValue) {
+      if (!parseCurve(argv[++i], curve)) badOption = true;
+      curveOnly = true;
+    } else if (arg == "--anneal" && hasValue) {
+      annealOptions.moves = strtoll(argv[++i], 0, 10);
+      if (annealOptions.moves < 1) badOption = true;
+      annealing = true;
+    } else if (arg == "--cooling" && hasValue) {
+      if (!parseCooling(argv[++i], annealOptions.cooling)) badOption = true;
+    } else if (arg == "--temperatures" && hasValue) {
+      char *rest;
+      annealOptions.startTemperature = strtod(argv[++i], &rest);
+      if (*rest == ':') annealOptions.endTemperature = strtod(rest + 1, &rest);
+      if (*rest != '\0' || annealOptions.startTemperature < 0 ||
+          annealOptions.endTemperature < 0) {
+        badOption = true;
+      }
+    } else if (arg == "--replicas" && hasValue) {
+      annealOptions.numReplicas = atoi(argv[++i]);
+      if (annealOptions.numReplicas < 1) badOption = true;
+    } else if (arg == "--exchange-every" && hasValue) {
+      annealOptions.exchangeInterval = atoi(argv[++i]);
+      if (annealOptions.exchangeInterval < 1) badOption = true;
+    } else if (arg == "--anneal-start" && hasValue) {
+      if (!parseInitStrategy(argv[++i], annealOptions.start)) badOption = true;
+    } else if (arg == "--polish") {
+      polish = true;
+    } else if (arg == "--neighbours" && hasValue) {
+      options.numNeighbours = atoi(argv[++i]);
+      if (options.numNeighbours < 1) badOption = true;
+    } else if (arg == "--islands" && hasValue) {
+      options.numIslands = atoi(argv[++i]);
+    } else if (arg == "--migrate-every" && hasValue) {
+      options.migrationInterval = atoi(argv[++i]);
+    } else if (arg == "--migrants" && hasValue) {
+      options.migrationSize = atoi(argv[++i]);
+    } else if (arg == "--topology" && hasValue) {
+      string topology = argv[++i];
+      if (topology == "ring") options.topology = MIGRATE_RING;
+      else if (topology == "random") options.topology = MIGRATE_RANDOM;
+      else badOption = true;
+    } else if (arg == "--checkpoint" && hasValue) {
+      options.checkpointPath = argv[++i];
+    } else if (arg == "--checkpoint-every" && hasValue) {
+      options.checkpointInterval = atoi(argv[++i]);
+      if (options.checkpointInterval < 1) badOption = true;
+    } else if (arg == "--resume" && hasValue) {
+      resumePath = argv[++i];
+    } else if (arg == "--telemetry" && hasValue) {
+      telemetryPath = argv[++i];
+    } else if (arg == "--telemetry-format" && hasValue) {
+      if (!parseTelemetryFormat(argv[++i], telemetryFormat)) badOption = true;
+      telemetryFormatSet = true;
+    } else if (arg == "--batch") {
+      batch = true;
+    } else if (batch) {
+      batchArgs.push_back(arg);
+    } else {
+      params.push_back(arg);
+    }
+  }
+
+  if ((params.size() != 4 && !((curveOnly || annealing) && params.empty())) ||
+      (curveOnly && annealing) ||
+      badOption || options.numThreads < 1 ||
+      options.numIslands < 1 || options.migrationInterval < 1 ||
+      options.migrationSize < 0 || (batch && batchArgs.empty()) ||
+      ((batch || curveOnly || annealing) &&
+       (!options.checkpointPath.empty() || !resumePath.empty() ||
+        !telemetryPath.empty()))) {
     usage(argv[0]);
     return 1;
   }
+  annealOptions.numThreads = options.numThreads;
+  annealOptions.seeded = options.seeded;
+  annealOptions.seed = options.seed;
+  annealOptions.numNeighbours = options.numNeighbours;
 
-  const int population = (int) atoi(argv[1]);
-  const int generations = (int) atoi(argv[2]);
-  const float keepFraction = (float) atof(argv[3]);
-  const float mutationFactor = (float) atof(argv[4]);
+  int population = 1, generations = 1;
+  float keepFraction = 0, mutationFactor = 0;
+  if (!params.empty()) {
+    population = (int) atoi(params[0].c_str());
+    generations = (int) atoi(params[1].c_str());
+    keepFraction = (float) atof(params[2].c_str());
+    mutationFactor = (float) atof(params[3].c_str());
+  }
 
+  //Tournaments pick two different parents, so need two genomes;
+  //truncation needs two in the elite it breeds from
+  const bool runsGA = !params.empty() && !curveOnly && !annealing;
   if (population < 1 || generations < 1 || keepFraction < 0 ||
-      keepFraction > 1 || mutationFactor < 0) {
+      keepFraction > 1 || mutationFactor < 0 ||
+      (runsGA && options.selection == SELECT_TOURNAMENT && population < 2) ||
+      (runsGA && options.selection == SELECT_TRUNCATION &&
+       (int) (keepFraction * population) < 2)) {
     usage(argv[0]);
     return 1;
   }
 
+  //Batch mode: instances run concurrently, each GA on a single thread
+  //and without progress output. A lone curve instance gets every thread.
+  if (batch) {
+    GAOptions instanceOptions = options;
+    instanceOptions.numThreads = 1;
+    instanceOptions.showProgress = false;
+    AnnealOptions instanceAnneal = annealOptions;
+    instanceAnneal.numThreads = 1;
+    instanceAnneal.showProgress = false;
+    vector<string> files = listInstanceFiles(batchArgs);
+    const int curveThreads = files.size() == 1 ? options.numThreads : 1;
+    int failed;
+    if (curveOnly && !polish) {
+      //Binary instances are used in place, without a copy
+      failed = runCloudBatch(files, options.numThreads,
+        [&](const PointCloud &cloud) {
+          return curveTour(cloud, curve, curveThreads);
+        }, cout);
+    } else {
+      failed = runBatch(files, options.numThreads,
+        [&](const vector<Point> &points) {
+          vector<int> order;
+          if (curveOnly) {
+            order = curveTour(points, curve, curveThreads);
+          } else if (annealing) {
+            order = annealTour(points, instanceAnneal).getOrder();
+          } else {
+            order = findAShortPath(points, population, generations,
+                                   keepFraction * population,
+                                   mutationFactor * population,
+                                   instanceOptions).getOrder();
+          }
+          if (polish) {
+            improveTour(order, DistanceMatrix(points),
+                        instanceOptions.numNeighbours);
+          }
+          return order;
+        }, cout);
+    }
+    return failed ? 1 : 0;
+  }
+
 	int nPoints;
 	double x, y, z;
 	Point p;
@@ -50,11 +229,68 @@ int main(int argc, char **argv) {
 		cout << endl;
 	}
 
-	//Find shortest path and output the result
+	//Pick up a saved run, if asked to, before starting
+	Checkpoint checkpoint;
+	if (!resumePath.empty()) {
+		string error;
+		if (!readCheckpoint(resumePath, checkpoint, error) ||
+		    !checkpointMatches(checkpoint, usrPoints, population,
+		                       (int) (keepFraction * population),
+		                       options.numIslands,
+		                       checkpointEngineCount(population,
+		                           (int) (keepFraction * population),
+		                           options.numIslands),
+		                       error)) {
+			cerr << resumePath << ": " << error << endl;
+			return 1;
+		}
+		options.resume = &checkpoint;
+	}
+
+	//Stream per-generation statistics, as JSON lines for a *.json or
+	//*.jsonl file unless told otherwise
+	ofstream telemetryFile;
+	unique_ptr<TelemetryWriter> telemetry;
+	if (!telemetryPath.empty()) {
+		telemetryFile.open(telemetryPath.c_str());
+		if (!telemetryFile) {
+			cerr << telemetryPath << ": cannot create file" << endl;
+			return 1;
+		}
+		size_t dot = telemetryPath.rfind('.');
+		string extension = dot == string::npos ? "" : telemetryPath.substr(dot);
+		if (!telemetryFormatSet && (extension == ".json" || extension == ".jsonl")) {
+			telemetryFormat = TELEMETRY_JSON;
+		}
+		telemetry.reset(new TelemetryWriter(telemetryFile, telemetryFormat));
+		TelemetryWriter *writer = telemetry.get();
+		options.telemetry = [writer](const GenerationStats &stats) {
+			writer->write(stats);
+		};
+	}
+
+	//Find shortest path and output the result; the curve alone is
+	//already an answer
 	TSPGenome shortPath(nPoints);
-	shortPath = findAShortPath(usrPoints, population, generations,
-                            keepFraction * population,
-                            mutationFactor * population);
+	if (curveOnly) {
+		shortPath = TSPGenome(curveTour(usrPoints, curve, options.numThreads));
+		shortPath.computeCircuitLength(usrPoints);
+	} else if (annealing) {
+		shortPath = annealTour(usrPoints, annealOptions);
+	} else {
+		shortPath = findAShortPath(usrPoints, population, generations,
+		                           keepFraction * population,
+		                           mutationFactor * population, options);
+	}
+
+	//Optionally finish with Lin-Kernighan on the best tour
+	if (polish) {
+		vector<int> order = shortPath.getOrder();
+		improveTour(order, DistanceMatrix(usrPoints, options.numThreads),
+		            options.numNeighbours, options.numThreads);
+		shortPath = TSPGenome(order);
+		shortPath.computeCircuitLength(usrPoints);
+	}
 	displayPath(shortPath.getOrder());
 
 	//Display its length
@@ -74,12 +310,94 @@ void displayPath(const vector<int> &order) {
 }
 
 void usage(const char *progname) {
-  cout << "Usage: " << progname << "population generations keep mutate"
-       << endl;
+  cout << "Usage: " << progname << " population generations keep mutate"
+       << " [--threads N] [--seed S]" << endl
+       << "       [--selection truncation|tournament] [--tournament-size K]"
+       << endl
+       << "       [--crossover prefix|ox|pmx|eax] [--mutation swap|reverse|neighbour]"
+       << endl
+       << "       [--init random:W,nn:W,greedy:W,curve:W]" << endl
+       << "       [--local-search none|offspring|elite] [--ls-moves 2opt|lk]"
+       << " [--neighbours K]" << endl << "       [--polish]" << endl
+       << "       [--islands N] [--migrate-every G] [--migrants M]"
+       << " [--topology ring|random]" << endl
+       << "       [--checkpoint file] [--checkpoint-every G] [--resume file]"
+       << endl
+       << "       [--telemetry file] [--telemetry-format csv|json]" << endl
+       << "       [--batch file|dir ...]" << endl
+       << "       " << progname << " --curve hilbert|morton [--polish]"
+       << " [--threads N] [--batch file|dir ...]" << endl
+       << "       " << progname << " --anneal MOVES"
+       << " [--cooling geometric|linear|reciprocal]" << endl
+       << "       [--temperatures T0[:T1]] [--replicas R] [--exchange-every M]"
+       << endl << "       [--anneal-start random|nn|greedy|curve]"
+       << " [--neighbours K] [--threads N] [--seed S]" << endl
+       << "       [--polish] [--batch file|dir ...]" << endl;
   cout << "\npopulation: positive integer" << endl;
   cout << "generations: positive integer" << endl;
-  cout << "keep: float between [0, 1]" << endl;
+  cout << "keep: float between [0, 1]; with truncation selection at least"
+       << " two genomes" << endl;
   cout << "mutate: nonnegative float" << endl;
+  cout << "\n--threads: worker threads (default: all cores)" << endl;
+  cout << "--seed: make the run reproducible (default: seeded from the OS)"
+       << endl;
+  cout << "--selection: breed from the keep best, or from the winners of"
+       << " tournaments" << endl << "  over the whole population"
+       << " (default truncation)" << endl;
+  cout << "--tournament-size: genomes per tournament (default 3)" << endl;
+  cout << "--init: weights of the ways to build the first generation:"
+       << " random" << endl << "  shuffles, nearest neighbour, greedy edge and"
+       << " Hilbert curve tours, each" << endl << "  strategy's first tour"
+       << " plain and the rest randomized (default random)" << endl;
+  cout << "--crossover: prefix (one cut), order, partially mapped or edge"
+       << " assembly" << endl << "  crossover (default prefix)" << endl;
+  cout << "--mutation: swap two cities, reverse the segment between them, or"
+       << " reverse" << endl << "  the segment that joins a city to a near"
+       << " neighbour (default swap)" << endl;
+  cout << "--local-search: improve new offspring, or each generation's"
+       << " elite," << endl << "  with 2-opt and Or-opt moves (default none)"
+       << endl;
+  cout << "--ls-moves: single 2-opt moves, or Lin-Kernighan chains of them,"
+       << " for" << endl << "  --local-search (default 2opt)" << endl;
+  cout << "--curve: skip the GA and visit the points in space-filling"
+       << " curve order," << endl << "  O(n log n), for instances of"
+       << " millions of points" << endl;
+  cout << "--anneal: skip the GA and run simulated annealing, MOVES move"
+       << " attempts per" << endl << "  replica" << endl;
+  cout << "--cooling: temperature schedule from T0 to T1 (default geometric)"
+       << endl;
+  cout << "--temperatures: start and end temperature in units of length"
+       << " (default: picked" << endl << "  from the instance)" << endl;
+  cout << "--replicas: parallel tempering with R replicas, up to ten times"
+       << " hotter, on" << endl << "  --threads threads (default 1)" << endl;
+  cout << "--exchange-every: moves between replica exchanges (default 1000)"
+       << endl;
+  cout << "--anneal-start: starting tour construction (default random)"
+       << endl;
+  cout << "--polish: improve the final tour with Lin-Kernighan and Or-opt"
+       << " moves" << endl;
+  cout << "--neighbours: candidate neighbours per city for local search"
+       << " (default 8)" << endl;
+  cout << "--islands: evolve N populations of the given size in parallel"
+       << " (default 1)" << endl;
+  cout << "--migrate-every: generations between migrations (default 20)"
+       << endl;
+  cout << "--migrants: best genomes each island sends per migration"
+       << " (default 2)" << endl;
+  cout << "--topology: send migrants to the next island or a random one"
+       << " (default ring)" << endl;
+  cout << "--checkpoint: save the run to file every G generations"
+       << " (--checkpoint-every," << endl << "  default 50)" << endl;
+  cout << "--resume: continue a run saved with --checkpoint; give the same"
+       << " parameters" << endl << "  and options" << endl;
+  cout << "--telemetry: write best, mean and worst length, diversity and"
+       << " phase times of" << endl << "  every generation to file"
+       << " (--telemetry-format, default csv; json for" << endl
+       << "  *.json and *.jsonl files)" << endl;
+  cout << "--batch: solve instance files (directories: every *.txt and *.pts"
+       << " inside) concurrently," << endl;
+  cout << "         printing one tab-separated result line per instance"
+       << endl;
 }
 
 